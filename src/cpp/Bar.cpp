@@ -20,12 +20,7 @@ using namespace std;
 CBar::CBar()
 {
 	NEN_ = 2;	// Each element has 2 nodes
-	nodes_ = new CNode*[NEN_];
-    
     ND_ = 6;
-    LocationMatrix_ = new unsigned int[ND_];
-
-	ElementMaterial_ = nullptr;
 }
 
 //	Desconstructor
@@ -34,13 +29,13 @@ CBar::~CBar()
 }
 
 //	Read element data from stream Input
-bool CBar::Read(ifstream& Input, CMaterial* MaterialSets, CNode* NodeList)
+bool CBar::Read(CTokenizer& Input, CMaterial* MaterialSets, CNode* NodeList)
 {
 	unsigned int MSet;	// Material property set number
 	unsigned int N1, N2;	// Left node number and right node number
 
 	Input >> N1 >> N2 >> MSet;
-    ElementMaterial_ = dynamic_cast<CBarMaterial*>(MaterialSets) + MSet - 1;
+    ElementMaterial_ = static_cast<CBarMaterial*>(MaterialSets) + MSet - 1;
 	nodes_[0] = &NodeList[N1 - 1];
 	nodes_[1] = &NodeList[N2 - 1];
 
@@ -58,12 +53,19 @@ void CBar::Write(COutputter& output)
 //	Upper triangular matrix, stored as an array column by colum starting from the diagonal element
 void CBar::ElementStiffness(double* Matrix)
 {
-	clear(Matrix, SizeOfStiffnessMatrix());
+	Stiffness(nodes_[0]->XYZ, nodes_[1]->XYZ, *static_cast<CBarMaterial*>(ElementMaterial_), Matrix);
+}
+
+//	Calculate the stiffness matrix of a bar from the coordinates of its nodes and its material
+//	Upper triangular matrix, stored as an array column by colum starting from the diagonal element
+void CBar::Stiffness(const double* XYZ1, const double* XYZ2, const CBarMaterial& Material, double* Matrix)
+{
+	clear(Matrix, 21);
 
 //	Calculate bar length
 	double DX[3];		//	dx = x2-x1, dy = y2-y1, dz = z2-z1
 	for (unsigned int i = 0; i < 3; i++)
-		DX[i] = nodes_[1]->XYZ[i] - nodes_[0]->XYZ[i];
+		DX[i] = XYZ2[i] - XYZ1[i];
 
 	double DX2[6];	//  Quadratic polynomial (dx^2, dy^2, dz^2, dx*dy, dy*dz, dx*dz)
 	DX2[0] = DX[0] * DX[0];
@@ -78,9 +80,7 @@ void CBar::ElementStiffness(double* Matrix)
 
 //	Calculate element stiffness matrix
 
-	CBarMaterial* material_ = dynamic_cast<CBarMaterial*>(ElementMaterial_);	// Pointer to material of the element
-
-	double k = material_->E * material_->Area / L / L2;
+	double k = Material.E * Material.Area / L / L2;
 
 	Matrix[0] = k*DX2[0];
 	Matrix[1] = k*DX2[1];
@@ -108,28 +108,36 @@ void CBar::ElementStiffness(double* Matrix)
 //	Calculate element stress 
 void CBar::ElementStress(double* stress, double* Displacement)
 {
-	CBarMaterial* material_ = dynamic_cast<CBarMaterial*>(ElementMaterial_);	// Pointer to material of the element
+	*stress = Stress(nodes_[0]->XYZ, nodes_[1]->XYZ, *static_cast<CBarMaterial*>(ElementMaterial_),
+					 LocationMatrix_, Displacement);
+}
 
+//	Calculate the stress of a bar from the coordinates of its nodes, its material and its location matrix
+double CBar::Stress(const double* XYZ1, const double* XYZ2, const CBarMaterial& Material,
+					const unsigned int* LocationMatrix, const double* Displacement)
+{
 	double DX[3];	//	dx = x2-x1, dy = y2-y1, dz = z2-z1
 	double L2 = 0;	//	Square of bar length (L^2)
 
 	for (unsigned int i = 0; i < 3; i++)
 	{
-		DX[i] = nodes_[1]->XYZ[i] - nodes_[0]->XYZ[i];
+		DX[i] = XYZ2[i] - XYZ1[i];
 		L2 = L2 + DX[i]*DX[i];
 	}
 
 	double S[6];
 	for (unsigned int i = 0; i < 3; i++)
 	{
-		S[i] = -DX[i] * material_->E / L2;
+		S[i] = -DX[i] * Material.E / L2;
 		S[i+3] = -S[i];
 	}
 	
-	*stress = 0.0;
+	double stress = 0.0;
 	for (unsigned int i = 0; i < 6; i++)
 	{
-		if (LocationMatrix_[i])
-			*stress += S[i] * Displacement[LocationMatrix_[i]-1];
+		if (LocationMatrix[i])
+			stress += S[i] * Displacement[LocationMatrix[i]-1];
 	}
+
+	return stress;
 }
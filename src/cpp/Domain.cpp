@@ -10,26 +10,42 @@
 
 #include "Domain.h"
 #include "Material.h"
+#include "Parallel.h"
+#include "Clock.h"
+#include "FactorCache.h"
+#include "Profiler.h"
+
+#include <climits>
+#include <cstdlib>
+#include <algorithm>
+#include <sstream>
+#include <cstring>
 
 using namespace std;
 
 //	Clear an array
-template <class type> void clear( type* a, unsigned int N )
+template <class type> void clear( type* a, size_t N )
 {
-	for (unsigned int i = 0; i < N; i++)
+	for (size_t i = 0; i < N; i++)
 		a[i] = 0;
 }
 
+template void clear<double>(double* a, size_t N);
+
 CDomain* CDomain::_instance = nullptr;
 
+const unsigned int CDomain::NRHS;
+
 //	Constructor
 CDomain::CDomain()
 {
 	Title[0] = '0';
 	MODEX = 0;
+	SolverType = SkylineLDLT;
 
 	NUMNP = 0;
 	NodeList = nullptr;
+	Coordinates = nullptr;
 	
 	NUMEG = 0;
 	EleGrpList = nullptr;
@@ -40,14 +56,30 @@ CDomain::CDomain()
 	
 	NEQ = 0;
 
+	Reorder = false;
+	MemoryBudget = 0;
+	MemoryLimit = 0;
+	MemoryAbort = false;
+	SparseEntries = 0;
+	Memory = CMemoryEstimate();
+	InputSize = 0;
+	ParseTime = 0;
+	NumberingTime = 0;
+	ColumnHeightsTime = 0;
+	NWKInput = 0;
+	MKInput = 0;
+
 	Force = nullptr;
+	ForceBlock = nullptr;
 	StiffnessMatrix = nullptr;
+	SparseStiffnessMatrix = nullptr;
 }
 
 //	Desconstructor
 CDomain::~CDomain()
 {
 	delete [] NodeList;
+	delete [] Coordinates;
 
 	delete [] EleGrpList;
 
@@ -55,7 +87,9 @@ CDomain::~CDomain()
 	delete [] LoadCases;
 
 	delete [] Force;
+	delete [] ForceBlock;
 	delete StiffnessMatrix;
+	delete SparseStiffnessMatrix;
 }
 
 //	Return pointer to the instance of the Domain class
@@ -67,12 +101,22 @@ CDomain* CDomain::GetInstance()
 	return _instance;
 }
 
+//	Delete the instance of the Domain class
+void CDomain::DeleteInstance()
+{
+	delete _instance;
+	_instance = nullptr;
+}
+
 //	Read domain data from the input data file
 bool CDomain::ReadData(string FileName, string OutFile)
 {
-	Input.open(FileName);
+	CProfileScope Scope("CDomain::ReadData");
+
+	if (FileName.size() > 5 && FileName.compare(FileName.size() - 5, 5, ".bdat") == 0)
+		return ReadBinaryData(FileName, OutFile);
 
-	if (!Input) 
+	if (!Input.Open(FileName))
 	{
 		cerr << "*** Error *** File " << FileName << " does not exist !" << endl;
 		exit(3);
@@ -80,34 +124,226 @@ bool CDomain::ReadData(string FileName, string OutFile)
 
 	COutputter* Output = COutputter::GetInstance(OutFile);
 
+//	The parse time is stopped while the data is echoed to the output file
+	Clock Parse;
+	Parse.Start();
+
 //	Read the heading line
 	Input.getline(Title, 256);
+
+	Parse.Stop();
 	Output->OutputHeading();
+	Parse.Resume();
 
-//	Read the control line
+//	Read the control line, with the solver type as an optional last field
 	Input >> NUMNP >> NUMEG >> NLCASE >> MODEX;
 
+	string Control = Input.GetRestOfLine();
+
+	unsigned int Solver;
+	if (istringstream(Control) >> Solver)
+		SolverType = Solver ? SparsePCG : SkylineLDLT;
+
 //	Read nodal point data
-	if (ReadNodalPoints())
-        Output->OutputNodeInfo();
-    else
-        return false;
+	bool Success = ReadNodalPoints();
+
+	Parse.Stop();
+	if (!Success)
+		return false;
+
+	Output->OutputNodeInfo();
+
+	StoreCoordinates();
 
 //	Update equation number
 	CalculateEquationNumber();
 	Output->OutputEquationNumber();
 
 //	Read load data
-	if (ReadLoadCases())
-        Output->OutputLoadInfo();
-    else
-        return false;
+	Parse.Resume();
+	Success = ReadLoadCases();
+	Parse.Stop();
+
+	if (!Success)
+		return false;
+
+	Output->OutputLoadInfo();
 
 //	Read element data
-	if (ReadElements())
-        Output->OutputElementInfo();
-    else
-        return false;
+	Parse.Resume();
+	Success = ReadElements();
+	Parse.Stop();
+
+	if (!Success)
+		return false;
+
+	Output->OutputElementInfo();
+
+	InputSize = Input.size();
+	ParseTime = Parse.ElapsedTime();
+
+	return true;
+}
+
+//	Read domain data from the binary input data file
+//	The arrays of the mapped file are copied to the domain, and the same data is output
+//	in the same order as for the text input data file
+bool CDomain::ReadBinaryData(string FileName, string OutFile)
+{
+	CProfileScope Scope("CDomain::ReadBinaryData");
+
+	CBinaryDeck Deck;
+
+	if (!Deck.OpenForRead(FileName))
+	{
+		cerr << "*** Error *** File " << FileName << " does not exist !" << endl;
+		exit(3);
+	}
+
+	COutputter* Output = COutputter::GetInstance(OutFile);
+
+	const char* Magic = Deck.Read<char>(8);
+	const unsigned int* Version = Deck.Read<unsigned int>(2);	// Version and byte order
+
+	if (!Magic || memcmp(Magic, CBinaryDeck::Magic(), 8) || !Version || Version[1] != CBinaryDeck::ByteOrder)
+	{
+		cerr << "*** Error *** File " << FileName << " is not a binary input data file of this machine !" << endl;
+		return false;
+	}
+
+	if (Version[0] != CBinaryDeck::Version)
+	{
+		cerr << "*** Error *** Binary input data file version " << Version[0] << " is not supported !" << endl;
+		return false;
+	}
+
+	auto Truncated = [&]()
+	{
+		cerr << "*** Error *** Binary input data file " << FileName << " is incomplete !" << endl;
+		return false;
+	};
+
+//	Heading and control data
+	const unsigned int* Control;
+	if (!Deck.Read(Title, 256) || !(Control = Deck.Read<unsigned int>(5)))
+		return Truncated();
+
+	Title[255] = '\0';
+	Output->OutputHeading();
+
+	NUMNP = Control[0];
+	NUMEG = Control[1];
+	NLCASE = Control[2];
+	MODEX = Control[3];
+	SolverType = Control[4] ? SparsePCG : SkylineLDLT;
+
+//	Nodal point data
+	const unsigned int* bcode = Deck.Read<unsigned int>((size_t)NUMNP * 3);
+	const double* XYZ = Deck.Read<double>((size_t)NUMNP * 3);
+	if (!bcode || !XYZ)
+		return Truncated();
+
+	NodeList = new CNode[NUMNP];
+	for (unsigned int np = 0; np < NUMNP; np++)
+	{
+		NodeList[np].NodeNumber = np + 1;
+		for (unsigned int dof = 0; dof < CNode::NDF; dof++)
+		{
+			NodeList[np].bcode[dof] = bcode[3*np + dof];
+			NodeList[np].XYZ[dof] = XYZ[3*np + dof];
+		}
+	}
+
+	Output->OutputNodeInfo();
+
+	StoreCoordinates();
+	CalculateEquationNumber();
+	Output->OutputEquationNumber();
+
+//	Load case data
+	LoadCases = new CLoadCaseData[NLCASE];
+	for (unsigned int lcase = 0; lcase < NLCASE; lcase++)
+	{
+		const unsigned int* NL = Deck.Read<unsigned int>(1);
+		if (!NL)
+			return Truncated();
+
+		CLoadCaseData& LoadCase = LoadCases[lcase];
+		LoadCase.Allocate(*NL);
+
+		if (!Deck.Read(LoadCase.node, *NL) || !Deck.Read(LoadCase.dof, *NL) || !Deck.Read(LoadCase.load, *NL))
+			return Truncated();
+	}
+
+	Output->OutputLoadInfo();
+
+//	Element data
+	EleGrpList = new CElementGroup[NUMEG];
+	for (unsigned int EleGrp = 0; EleGrp < NUMEG; EleGrp++)
+		if (!EleGrpList[EleGrp].Read(Deck))
+			return Truncated();
+
+	Output->OutputElementInfo();
+
+	return true;
+}
+
+//	Write the domain data read from an input data file to the binary input data file FileName
+bool CDomain::WriteBinaryData(string FileName)
+{
+	CProfileScope Scope("CDomain::WriteBinaryData");
+
+	CBinaryDeck Deck;
+
+	if (!Deck.OpenForWrite(FileName))
+	{
+		cerr << "*** Error *** File " << FileName << " cannot be created !" << endl;
+		return false;
+	}
+
+	unsigned int Version[2] = {CBinaryDeck::Version, CBinaryDeck::ByteOrder};
+	unsigned int Control[5] = {NUMNP, NUMEG, NLCASE, MODEX, (unsigned int)SolverType};
+
+	Deck.Write(CBinaryDeck::Magic(), 8);
+	Deck.Write(Version, 2);
+	char Heading[256] = {0};
+	memcpy(Heading, Title, strnlen(Title, 255));
+
+	Deck.Write(Heading, 256);
+	Deck.Write(Control, 5);
+
+//	The boundary codes have been replaced by the equation numbers when the data was read
+	vector<unsigned int> bcode((size_t)NUMNP * 3);
+	vector<double> XYZ((size_t)NUMNP * 3);
+
+	for (unsigned int np = 0; np < NUMNP; np++)
+		for (unsigned int dof = 0; dof < CNode::NDF; dof++)
+		{
+			bcode[3*np + dof] = NodeList[np].bcode[dof] ? 0 : 1;
+			XYZ[3*np + dof] = NodeList[np].XYZ[dof];
+		}
+
+	Deck.Write(bcode.data(), bcode.size());
+	Deck.Write(XYZ.data(), XYZ.size());
+
+	for (unsigned int lcase = 0; lcase < NLCASE; lcase++)
+	{
+		CLoadCaseData& LoadCase = LoadCases[lcase];
+
+		Deck.Write(LoadCase.nloads);
+		Deck.Write(LoadCase.node, LoadCase.nloads);
+		Deck.Write(LoadCase.dof, LoadCase.nloads);
+		Deck.Write(LoadCase.load, LoadCase.nloads);
+	}
+
+	for (unsigned int EleGrp = 0; EleGrp < NUMEG; EleGrp++)
+		EleGrpList[EleGrp].Write(Deck);
+
+	if (!Deck.Close())
+	{
+		cerr << "*** Error *** File " << FileName << " cannot be written !" << endl;
+		return false;
+	}
 
 	return true;
 }
@@ -115,10 +351,16 @@ bool CDomain::ReadData(string FileName, string OutFile)
 //	Read nodal point data
 bool CDomain::ReadNodalPoints()
 {
+	CProfileScope Scope("CDomain::ReadNodalPoints");
 
 //	Read nodal point data lines
 	NodeList = new CNode[NUMNP];
 
+//	Read the nodal point lines on all threads, checking the order of the nodes
+	if (Input.ReadLines(NUMNP, [this](CTokenizer& Chunk, unsigned int np)
+		{ return NodeList[np].Read(Chunk) && NodeList[np].NodeNumber == np + 1; }))
+		return true;
+
 //	Loop over for all nodal points
 	for (unsigned int np = 0; np < NUMNP; np++)
     {
@@ -138,9 +380,26 @@ bool CDomain::ReadNodalPoints()
 	return true;
 }
 
+//	Store the coordinates of all nodes in one array
+//	The element kernels read the coordinates of a node from 24 consecutive bytes, instead of
+//	from the node objects, which also hold the node number and the equation numbers
+void CDomain::StoreCoordinates()
+{
+	Coordinates = new double[3 * (size_t)NUMNP];
+
+	for (unsigned int np = 0; np < NUMNP; np++)
+		for (unsigned int i = 0; i < 3; i++)
+			Coordinates[3 * (size_t)np + i] = NodeList[np].XYZ[i];
+}
+
 //	Calculate global equation numbers corresponding to every degree of freedom of each node
 void CDomain::CalculateEquationNumber()
 {
+	CProfileScope Scope("CDomain::CalculateEquationNumber");
+
+	Clock Numbering;
+	Numbering.Start();
+
 	NEQ = 0;
 	for (unsigned int np = 0; np < NUMNP; np++)	// Loop over for all node
 	{
@@ -155,11 +414,283 @@ void CDomain::CalculateEquationNumber()
 			}
 		}
 	}
+
+	NumberingTime = Numbering.ElapsedTime();
+}
+
+//	Return the FNV-1a hash of the coordinates and equation numbers of the nodes
+uint64_t CDomain::CalculateNodeHash()
+{
+	uint64_t Hash = CFactorCache::FNV1a(&NUMNP, sizeof(NUMNP));
+	Hash = CFactorCache::FNV1a(Coordinates, 3 * (size_t)NUMNP * sizeof(double), Hash);
+
+	for (unsigned int np = 0; np < NUMNP; np++)
+		Hash = CFactorCache::FNV1a(NodeList[np].bcode, sizeof(NodeList[np].bcode), Hash);
+
+	return Hash;
+}
+
+//	Return the FNV-1a hash of the nodes, elements and material sets, which determine the stiffness matrix
+uint64_t CDomain::CalculateStructureHash()
+{
+	uint64_t Hash = CFactorCache::FNV1a(&NUMEG, sizeof(NUMEG), CalculateNodeHash());
+
+	for (unsigned int EleGrp = 0; EleGrp < NUMEG; EleGrp++)
+	{
+		CElementGroup& ElementGrp = EleGrpList[EleGrp];
+
+		unsigned int Sizes[] = {(unsigned int)ElementGrp.GetElementType(), ElementGrp.GetNUME(), ElementGrp.GetNUMMAT()};
+		Hash = CFactorCache::FNV1a(Sizes, sizeof(Sizes), Hash);
+
+		for (unsigned int mset = 0; mset < ElementGrp.GetNUMMAT(); mset++)
+		{
+			CMaterial& Material = ElementGrp.GetMaterial(mset);
+
+			vector<double> Properties(Material.GetNumberOfProperties());
+			Material.GetProperties(Properties.data());
+			Hash = CFactorCache::FNV1a(Properties.data(), Properties.size() * sizeof(double), Hash);
+		}
+
+		if (ElementGrp.GetNUME())
+		{
+			Hash = CFactorCache::FNV1a(ElementGrp.GetConnectivity(0),
+									   (size_t)ElementGrp.GetNUME() * ElementGrp.GetNEN() * sizeof(unsigned int), Hash);
+			Hash = CFactorCache::FNV1a(ElementGrp.GetMaterialSets(), (size_t)ElementGrp.GetNUME() * sizeof(unsigned int), Hash);
+		}
+	}
+
+	return Hash;
+}
+
+//	Append Count values of Data to the byte array Records
+template <class T_>
+static void AppendRecords(vector<char>& Records, const T_* Data, size_t Count)
+{
+	Records.insert(Records.end(), (const char*)Data, (const char*)(Data + Count));
+}
+
+//	Copy Count values at Position of the byte array Records to Data, and advance Position
+//	Return false if Records ends before
+template <class T_>
+static bool ExtractRecords(const vector<char>& Records, size_t& Position, T_* Data, size_t Count)
+{
+	if ((Records.size() - Position) / sizeof(T_) < Count)
+		return false;
+
+	memcpy(Data, Records.data() + Position, Count * sizeof(T_));
+	Position += Count * sizeof(T_);
+
+	return true;
+}
+
+//	Return the material properties of all material sets of an element group ([NUMMAT][NPROP])
+static vector<double> GetMaterialProperties(CElementGroup& ElementGrp, unsigned int NPROP)
+{
+	vector<double> Properties((size_t)ElementGrp.GetNUMMAT() * NPROP);
+
+	for (unsigned int mset = 0; mset < ElementGrp.GetNUMMAT(); mset++)
+		ElementGrp.GetMaterial(mset).GetProperties(Properties.data() + (size_t)mset * NPROP);
+
+	return Properties;
+}
+
+//	Return the number of material properties of the elements of a group
+static unsigned int GetNumberOfProperties(CElementGroup& ElementGrp)
+{
+	return ElementGrp.GetNUMMAT() ? ElementGrp.GetMaterial(0).GetNumberOfProperties() : 0;
+}
+
+//	Store the elements and material sets of all element groups in Records
+//	For each group : type, NUME, NEN, NUMMAT, number of properties NPROP (unsigned int), the
+//	properties of the material sets (double [NUMMAT][NPROP]), the nodes (unsigned int [NUME][NEN])
+//	and the material sets (unsigned int [NUME]) of the elements
+void CDomain::GetElementRecords(vector<char>& Records)
+{
+	Records.clear();
+	AppendRecords(Records, &NUMEG, 1);
+
+	for (unsigned int EleGrp = 0; EleGrp < NUMEG; EleGrp++)
+	{
+		CElementGroup& ElementGrp = EleGrpList[EleGrp];
+		unsigned int NPROP = GetNumberOfProperties(ElementGrp);
+
+		unsigned int Sizes[] = {(unsigned int)ElementGrp.GetElementType(), ElementGrp.GetNUME(), ElementGrp.GetNEN(),
+								ElementGrp.GetNUMMAT(), NPROP};
+		AppendRecords(Records, Sizes, 5);
+
+		vector<double> Properties = GetMaterialProperties(ElementGrp, NPROP);
+		AppendRecords(Records, Properties.data(), Properties.size());
+
+		if (ElementGrp.GetNUME())
+		{
+			AppendRecords(Records, ElementGrp.GetConnectivity(0), (size_t)ElementGrp.GetNUME() * ElementGrp.GetNEN());
+			AppendRecords(Records, ElementGrp.GetMaterialSets(), ElementGrp.GetNUME());
+		}
+	}
+}
+
+//	Call Body(ElementGrp, Nodes, Properties, OldNodes, OldProperties) for every element that differs
+//	from the element of the same index in Records. Nodes and Properties are nullptr for a removed
+//	element, and OldNodes and OldProperties for an added element
+template <class Function>
+bool CDomain::CompareElements(const vector<char>& Records, Function Body)
+{
+	size_t Position = 0;
+	unsigned int Groups;
+
+	if (!ExtractRecords(Records, Position, &Groups, 1) || Groups != NUMEG)
+		return false;
+
+	for (unsigned int EleGrp = 0; EleGrp < NUMEG; EleGrp++)
+	{
+		CElementGroup& ElementGrp = EleGrpList[EleGrp];
+		unsigned int NUME = ElementGrp.GetNUME();
+		unsigned int NEN = ElementGrp.GetNEN();
+		unsigned int NPROP = GetNumberOfProperties(ElementGrp);
+
+		unsigned int Sizes[5];	// Type, NUME, NEN, NUMMAT and NPROP of the group in Records
+		if (!ExtractRecords(Records, Position, Sizes, 5) || Sizes[0] != (unsigned int)ElementGrp.GetElementType() ||
+			Sizes[2] != NEN || Sizes[4] != NPROP)
+			return false;
+
+		vector<double> OldProperties((size_t)Sizes[3] * NPROP);
+		vector<unsigned int> OldConnectivity((size_t)Sizes[1] * NEN);
+		vector<unsigned int> OldMaterialSets(Sizes[1]);
+
+		if (!ExtractRecords(Records, Position, OldProperties.data(), OldProperties.size()) ||
+			!ExtractRecords(Records, Position, OldConnectivity.data(), OldConnectivity.size()) ||
+			!ExtractRecords(Records, Position, OldMaterialSets.data(), OldMaterialSets.size()))
+			return false;
+
+		vector<double> Properties = GetMaterialProperties(ElementGrp, NPROP);
+		const unsigned int* MaterialSets = ElementGrp.GetMaterialSets();
+
+		for (unsigned int Ele = 0; Ele < max(NUME, Sizes[1]); Ele++)
+		{
+			const unsigned int* Nodes = Ele < NUME ? ElementGrp.GetConnectivity(Ele) : nullptr;
+			const unsigned int* OldNodes = Ele < Sizes[1] ? OldConnectivity.data() + (size_t)Ele * NEN : nullptr;
+			const double* Material = Nodes ? Properties.data() + (size_t)MaterialSets[Ele] * NPROP : nullptr;
+			const double* OldMaterial = nullptr;
+
+			if (OldNodes)
+			{
+				if (OldMaterialSets[Ele] >= Sizes[3])
+					return false;
+
+				for (unsigned int N = 0; N < NEN; N++)
+					if (OldNodes[N] >= NUMNP)
+						return false;
+
+				OldMaterial = OldProperties.data() + (size_t)OldMaterialSets[Ele] * NPROP;
+			}
+
+			if (Nodes && OldNodes && !memcmp(Nodes, OldNodes, NEN * sizeof(unsigned int)) &&
+				!memcmp(Material, OldMaterial, NPROP * sizeof(double)))
+				continue;
+
+			Body(ElementGrp, Nodes, Material, OldNodes, OldMaterial);
+		}
+	}
+
+	return true;
+}
+
+//	Calculate the update of the stiffness matrix from the elements of Records to the current elements
+//	The elements are compared by their index in each group. An element whose nodes or material
+//	properties differ contributes the difference of its stiffness matrices, an added element its
+//	stiffness matrix, and a removed element its negative stiffness matrix
+bool CDomain::CalculateStiffnessUpdate(const vector<char>& Records, unsigned int MaximumRank,
+									   vector<unsigned int>& Equations, vector<double>& Update, unsigned int& Changed)
+{
+	CProfileScope Scope("CDomain::CalculateStiffnessUpdate");
+
+//	Collect the equations touched by the changed elements
+	vector<bool> Touched(NEQ + 1, false);
+
+	auto Touch = [&](const unsigned int* Nodes, unsigned int NEN)
+	{
+		for (unsigned int N = 0; Nodes && N < NEN; N++)
+			for (unsigned int D = 0; D < CNode::NDF; D++)
+				Touched[NodeList[Nodes[N]].bcode[D]] = true;
+	};
+
+	Changed = 0;
+
+	if (!CompareElements(Records, [&](CElementGroup& ElementGrp, const unsigned int* Nodes, const double*,
+									  const unsigned int* OldNodes, const double*)
+		{
+			Changed++;
+			Touch(Nodes, ElementGrp.GetNEN());
+			Touch(OldNodes, ElementGrp.GetNEN());
+		}))
+		return false;
+
+	Equations.clear();
+	for (unsigned int L = 1; L <= NEQ; L++)
+		if (Touched[L])
+			Equations.push_back(L);
+
+	Update.clear();
+
+	size_t m = Equations.size();
+	if (m > MaximumRank)
+		return true;
+
+//	Assemble the contributions of the changed elements to the full symmetric matrix of the update
+	Update.assign(m * m, 0.0);
+
+	auto Add = [&](CElementGroup& ElementGrp, const unsigned int* Nodes, const double* Properties, double Sign)
+	{
+		if (!Nodes)
+			return;
+
+		unsigned int ND = ElementGrp.GetND();
+		vector<double> Matrix(ND * (ND + 1) / 2);
+		ElementGrp.ComputeStiffness(Nodes, Properties, Matrix.data());
+
+		vector<unsigned int> LocationMatrix;
+		for (unsigned int N = 0; N < ElementGrp.GetNEN(); N++)
+			for (unsigned int D = 0; D < CNode::NDF; D++)
+				LocationMatrix.push_back(NodeList[Nodes[N]].bcode[D]);
+
+		for (unsigned int j = 0; j < ND; j++)
+		{
+			if (!LocationMatrix[j])
+				continue;
+
+			size_t b = lower_bound(Equations.begin(), Equations.end(), LocationMatrix[j]) - Equations.begin();
+			unsigned int DiagjElement = (j+1)*j/2;
+
+			for (unsigned int i = 0; i <= j; i++)
+			{
+				if (!LocationMatrix[i])
+					continue;
+
+				size_t a = lower_bound(Equations.begin(), Equations.end(), LocationMatrix[i]) - Equations.begin();
+				double Value = Sign * Matrix[DiagjElement + j - i];
+
+				Update[a * m + b] += Value;
+				if (a != b)
+					Update[b * m + a] += Value;
+			}
+		}
+	};
+
+	CompareElements(Records, [&](CElementGroup& ElementGrp, const unsigned int* Nodes, const double* Properties,
+								 const unsigned int* OldNodes, const double* OldProperties)
+	{
+		Add(ElementGrp, Nodes, Properties, 1.0);
+		Add(ElementGrp, OldNodes, OldProperties, -1.0);
+	});
+
+	return true;
 }
 
 //	Read load case data
 bool CDomain::ReadLoadCases()
 {
+	CProfileScope Scope("CDomain::ReadLoadCases");
+
 //	Read load data lines
 	LoadCases = new CLoadCaseData[NLCASE];	// List all load cases
 
@@ -187,6 +718,8 @@ bool CDomain::ReadLoadCases()
 // Read element data
 bool CDomain::ReadElements()
 {
+    CProfileScope Scope("CDomain::ReadElements");
+
     EleGrpList = new CElementGroup[NUMEG];
 
 //	Loop over for all element group
@@ -200,6 +733,8 @@ bool CDomain::ReadElements()
 //	Calculate column heights
 void CDomain::CalculateColumnHeights()
 {
+	CProfileScope Scope("CDomain::CalculateColumnHeights");
+
 #ifdef _DEBUG_
     COutputter* Output = COutputter::GetInstance();
     *Output << setw(9) << "Ele = " << setw(22) << "Location Matrix" << endl;
@@ -210,23 +745,23 @@ void CDomain::CalculateColumnHeights()
         CElementGroup& ElementGrp = EleGrpList[EleGrp];
         unsigned int NUME = ElementGrp.GetNUME();
         
+        unsigned int ND = ElementGrp.GetND();
+
+        // Generate location matrix
+        ElementGrp.GenerateLocationMatrices();
+
 		for (unsigned int Ele = 0; Ele < NUME; Ele++)	//	Loop over for all elements in group EleGrp
         {
-            CElement& Element = ElementGrp[Ele];
+            unsigned int* LocationMatrix = ElementGrp.GetLocationMatrix(Ele);
 
-            // Generate location matrix
-            Element.GenerateLocationMatrix();
-            
 #ifdef _DEBUG_
-            unsigned int* LocationMatrix = Element.GetLocationMatrix();
-            
             *Output << setw(9) << Ele+1;
-            for (int i=0; i<Element.GetND(); i++)
+            for (int i=0; i<ND; i++)
                 *Output << setw(5) << LocationMatrix[i];
             *Output << endl;
 #endif
 
-            StiffnessMatrix->CalculateColumnHeight(Element.GetLocationMatrix(), Element.GetND());
+            StiffnessMatrix->CalculateColumnHeight(LocationMatrix, ND);
         }
     }
     
@@ -239,63 +774,629 @@ void CDomain::CalculateColumnHeights()
 
 }
 
+//	Calculate the sparsity pattern of the sparse stiffness matrix
+void CDomain::CalculateSparsity()
+{
+	CProfileScope Scope("CDomain::CalculateSparsity");
+
+//  Count the entries of every row contributed by all elements
+	for (unsigned int EleGrp = 0; EleGrp < NUMEG; EleGrp++)
+    {
+        CElementGroup& ElementGrp = EleGrpList[EleGrp];
+        unsigned int NUME = ElementGrp.GetNUME();
+
+        // Generate location matrix
+        ElementGrp.GenerateLocationMatrices();
+
+		for (unsigned int Ele = 0; Ele < NUME; Ele++)
+            SparseStiffnessMatrix->CountEntries(ElementGrp.GetLocationMatrix(Ele), ElementGrp.GetND());
+    }
+
+    SparseStiffnessMatrix->AllocatePattern();
+
+//  Add the column numbers of the entries contributed by all elements
+	for (unsigned int EleGrp = 0; EleGrp < NUMEG; EleGrp++)
+    {
+        CElementGroup& ElementGrp = EleGrpList[EleGrp];
+        unsigned int NUME = ElementGrp.GetNUME();
+
+		for (unsigned int Ele = 0; Ele < NUME; Ele++)
+            SparseStiffnessMatrix->AddEntries(ElementGrp.GetLocationMatrix(Ele), ElementGrp.GetND());
+    }
+
+    SparseStiffnessMatrix->CompressPattern();
+}
+
+//	Renumber the equations to reduce the profile of the stiffness matrix (reverse Cuthill-McKee)
+void CDomain::ReorderEquationNumbers()
+{
+    CProfileScope Scope("CDomain::ReorderEquationNumbers");
+
+    CalculateProfile(NWKInput, MKInput);
+
+//  Build the node adjacency graph (compressed rows) from the element connectivity
+    vector<unsigned int> Degree(NUMNP + 1, 0);
+    vector<pair<unsigned int, unsigned int> > Edges;
+
+    for (unsigned int EleGrp = 0; EleGrp < NUMEG; EleGrp++)
+    {
+        CElementGroup& ElementGrp = EleGrpList[EleGrp];
+        unsigned int NUME = ElementGrp.GetNUME();
+
+        unsigned int NEN = ElementGrp.GetNEN();
+
+        for (unsigned int Ele = 0; Ele < NUME; Ele++)
+        {
+            const unsigned int* Nodes = ElementGrp.GetConnectivity(Ele);
+
+            for (unsigned int a = 0; a < NEN; a++)
+                for (unsigned int b = 0; b < NEN; b++)
+                    if (Nodes[a] != Nodes[b])
+                        Edges.push_back(make_pair(Nodes[a], Nodes[b]));
+        }
+    }
+
+    sort(Edges.begin(), Edges.end());
+    Edges.erase(unique(Edges.begin(), Edges.end()), Edges.end());
+
+    vector<unsigned int> AdjacencyStart(NUMNP + 1, 0);
+    vector<unsigned int> Adjacency(Edges.size());
+
+    for (size_t e = 0; e < Edges.size(); e++)
+    {
+        AdjacencyStart[Edges[e].first + 1]++;
+        Adjacency[e] = Edges[e].second;
+    }
+
+    for (unsigned int np = 0; np < NUMNP; np++)
+    {
+        AdjacencyStart[np + 1] += AdjacencyStart[np];
+        Degree[np] = AdjacencyStart[np + 1] - AdjacencyStart[np];
+    }
+
+    Edges.clear();
+
+//  Sort the neighbours of each node by increasing degree
+    for (unsigned int np = 0; np < NUMNP; np++)
+        stable_sort(Adjacency.begin() + AdjacencyStart[np], Adjacency.begin() + AdjacencyStart[np + 1],
+                    [&](unsigned int a, unsigned int b) { return Degree[a] < Degree[b]; });
+
+//  Breadth first search from Root over the unnumbered nodes. The nodes reached are appended
+//  to Order, and the number of levels of the level structure is returned.
+    vector<bool> Numbered(NUMNP, false);
+    vector<unsigned int> Level(NUMNP, 0);
+    vector<unsigned int> Order;
+    Order.reserve(NUMNP);
+
+    auto BreadthFirstSearch = [&](unsigned int Root, vector<unsigned int>& Visited)
+    {
+        size_t First = Visited.size();
+        Visited.push_back(Root);
+        Numbered[Root] = true;
+        Level[Root] = 0;
+
+        unsigned int Depth = 0;
+        for (size_t k = First; k < Visited.size(); k++)
+        {
+            unsigned int np = Visited[k];
+            Depth = Level[np];
+
+            for (unsigned int a = AdjacencyStart[np]; a < AdjacencyStart[np + 1]; a++)
+            {
+                unsigned int nb = Adjacency[a];
+                if (Numbered[nb])
+                    continue;
+
+                Numbered[nb] = true;
+                Level[nb] = Level[np] + 1;
+                Visited.push_back(nb);
+            }
+        }
+
+        return Depth + 1;
+    };
+
+//  Number every connected component of the graph, starting from a pseudo-peripheral node
+    vector<unsigned int> Component;
+
+    for (unsigned int Start = 0; Start < NUMNP; Start++)
+    {
+        if (Numbered[Start])
+            continue;
+
+//      Find a pseudo-peripheral node (George and Liu): start from a node of minimum degree and
+//      move to a node of minimum degree in the last level as long as the number of levels increases
+        unsigned int Root = Start;
+        Component.clear();
+        BreadthFirstSearch(Root, Component);
+
+        for (unsigned int np : Component)
+            if (Degree[np] < Degree[Root])
+                Root = np;
+
+        unsigned int Depth = 0;
+        for (;;)
+        {
+            for (unsigned int np : Component)
+                Numbered[np] = false;
+
+            Component.clear();
+            unsigned int NewDepth = BreadthFirstSearch(Root, Component);
+
+            if (NewDepth <= Depth)
+                break;
+
+            Depth = NewDepth;
+
+            unsigned int Candidate = Component.back();
+            for (size_t k = Component.size() - 1; k > 0 && Level[Component[k - 1]] == Depth - 1; k--)
+                if (Degree[Component[k - 1]] < Degree[Candidate])
+                    Candidate = Component[k - 1];
+
+            Root = Candidate;
+        }
+
+        Order.insert(Order.end(), Component.begin(), Component.end());
+    }
+
+//  Number the equations in the reverse Cuthill-McKee order of the nodes
+    vector<unsigned int> InputNumbers(CNode::NDF * NUMNP);
+    for (unsigned int np = 0; np < NUMNP; np++)
+        for (unsigned int dof = 0; dof < CNode::NDF; dof++)
+            InputNumbers[CNode::NDF * np + dof] = NodeList[np].bcode[dof];
+
+    unsigned int Equation = 0;
+    for (size_t k = Order.size(); k > 0; k--)
+    {
+        CNode& Node = NodeList[Order[k - 1]];
+
+        for (unsigned int dof = 0; dof < CNode::NDF; dof++)
+            if (Node.bcode[dof])
+                Node.bcode[dof] = ++Equation;
+    }
+
+    size_t NWK;
+    unsigned int MK;
+    CalculateProfile(NWK, MK);
+
+//  Keep the input numbering if the profile is not reduced
+    if (NWK >= NWKInput)
+        for (unsigned int np = 0; np < NUMNP; np++)
+            for (unsigned int dof = 0; dof < CNode::NDF; dof++)
+                NodeList[np].bcode[dof] = InputNumbers[CNode::NDF * np + dof];
+}
+
+//	Calculate the size of the skyline and the maximum half bandwidth for the current equation numbers
+void CDomain::CalculateProfile(size_t& NWK, unsigned int& MK)
+{
+    vector<unsigned int> ColumnHeights(NEQ, 0);
+
+    for (unsigned int EleGrp = 0; EleGrp < NUMEG; EleGrp++)
+    {
+        CElementGroup& ElementGrp = EleGrpList[EleGrp];
+        unsigned int NUME = ElementGrp.GetNUME();
+
+        unsigned int ND = ElementGrp.GetND();
+
+        ElementGrp.GenerateLocationMatrices();
+
+        for (unsigned int Ele = 0; Ele < NUME; Ele++)
+        {
+            unsigned int* LocationMatrix = ElementGrp.GetLocationMatrix(Ele);
+
+            unsigned int nfirstrow = UINT_MAX;
+            for (unsigned int i = 0; i < ND; i++)
+                if (LocationMatrix[i] && LocationMatrix[i] < nfirstrow)
+                    nfirstrow = LocationMatrix[i];
+
+            for (unsigned int i = 0; i < ND; i++)
+                if (LocationMatrix[i])
+                    ColumnHeights[LocationMatrix[i] - 1] = max(ColumnHeights[LocationMatrix[i] - 1], LocationMatrix[i] - nfirstrow);
+        }
+    }
+
+    NWK = 0;
+    MK = 0;
+    for (unsigned int i = 0; i < NEQ; i++)
+    {
+        NWK += ColumnHeights[i] + 1;
+        MK = max(MK, ColumnHeights[i]);
+    }
+
+    MK = MK + 1;
+}
+
+//	Calculate the memory of the arrays of the solution with the solver Type and the out of core budget Budget
+CMemoryEstimate CDomain::CalculateMemory(SolverTypes Type, size_t Budget)
+{
+    CMemoryEstimate Estimate;
+
+    Estimate.Nodes = (size_t)NUMNP * (sizeof(CNode) + 3 * sizeof(double));
+
+    Estimate.Elements = 0;
+    for (unsigned int EleGrp = 0; EleGrp < NUMEG; EleGrp++)
+        Estimate.Elements += EleGrpList[EleGrp].GetMemorySize();
+
+    Estimate.Loads = (size_t)NLCASE * sizeof(CLoadCaseData);
+    for (unsigned int lcase = 0; lcase < NLCASE; lcase++)
+        Estimate.Loads += (size_t)LoadCases[lcase].nloads * (2 * sizeof(unsigned int) + sizeof(double));
+
+    Estimate.ScratchFile = 0;
+
+    if (Type == SparsePCG)
+    {
+        //    Force vector, and the residual, preconditioned residual, search direction and its product with K
+        Estimate.Vectors = 5 * (size_t)NEQ * sizeof(double);
+
+        //    Row starts, column indices counted with duplicates, values and incomplete Cholesky factor
+        Estimate.Matrix = ((size_t)NEQ + 1) * sizeof(size_t) + SparseEntries * (sizeof(unsigned int) + 2 * sizeof(double));
+    }
+    else
+    {
+        //    Force vector, force/displacement vectors of a block of load cases and diagonal of the back substitution
+        Estimate.Vectors = (2 + (size_t)min(NLCASE, NRHS)) * NEQ * sizeof(double);
+
+        //    Column heights, diagonal addresses and the skyline, whose columns out of core are held in
+        //    memory up to the budget
+        size_t Skyline = StiffnessMatrix->size() * sizeof(double);
+
+        Estimate.Matrix = (size_t)NEQ * sizeof(unsigned int) + ((size_t)NEQ + 1) * sizeof(size_t);
+
+        if (!Budget)
+            Estimate.Matrix += Skyline;
+        else
+        {
+            Estimate.Matrix += min(Budget, Skyline);
+            Estimate.ScratchFile = Skyline;
+        }
+    }
+
+    return Estimate;
+}
+
+//    Renumber the equations, calculate the column heights and the memory of the solution, and
+//    select the solver for the memory limit
+bool CDomain::EstimateMemory()
+{
+    CProfileScope Scope("CDomain::EstimateMemory");
+
+    //    Renumber the equations to reduce the profile of the stiffness matrix
+    if (Reorder)
+    {
+        Clock Numbering;
+        Numbering.Start();
+
+        ReorderEquationNumbers();
+
+        NumberingTime += Numbering.ElapsedTime();
+
+        COutputter* Output = COutputter::GetInstance();
+        *Output << " EQUATION NUMBERS AFTER REVERSE CUTHILL-MCKEE REORDERING" << endl << endl;
+        Output->OutputEquationNumber();
+    }
+
+    if (SolverType == SkylineLDLT)
+    {
+        //  Create the banded stiffness matrix
+        StiffnessMatrix = new CSkylineMatrix<double>(NEQ);
+
+        Clock Profile;
+        Profile.Start();
+
+        //    Calculate column heights
+        CalculateColumnHeights();
+
+        //    Calculate address of diagonal elements in banded matrix
+        StiffnessMatrix->CalculateDiagnoalAddress();
+
+        ColumnHeightsTime = Profile.ElapsedTime();
+    }
+
+    //    Count the entries of the sparse stiffness matrix as CSparseMatrix::CountEntries, when the PCG
+    //    solver is selected or may be selected for the memory limit
+    if (SolverType == SparsePCG || (MemoryLimit && !MemoryAbort))
+    {
+        SparseEntries = NEQ;
+
+        for (unsigned int EleGrp = 0; EleGrp < NUMEG; EleGrp++)
+        {
+            CElementGroup& ElementGrp = EleGrpList[EleGrp];
+            unsigned int NUME = ElementGrp.GetNUME();
+            unsigned int ND = ElementGrp.GetND();
+
+            ElementGrp.GenerateLocationMatrices();
+
+            for (unsigned int Ele = 0; Ele < NUME; Ele++)
+            {
+                unsigned int* LocationMatrix = ElementGrp.GetLocationMatrix(Ele);
+
+                for (unsigned int i = 0; i < ND; i++)
+                    if (LocationMatrix[i])
+                        for (unsigned int j = 0; j < ND; j++)
+                            SparseEntries += (LocationMatrix[j] >= LocationMatrix[i]);
+            }
+        }
+    }
+
+    Memory = CalculateMemory(SolverType, MemoryBudget);
+
+    if (!MemoryLimit || Memory.Total() <= MemoryLimit)
+        return true;
+
+    if (MemoryAbort)
+        return false;
+
+    if (SolverType == SkylineLDLT)
+    {
+        //    Store the skyline out of core with the remaining memory as budget, if a block of the
+        //    out of core solver (a quarter of the budget) holds the longest column
+        size_t Skyline = StiffnessMatrix->size() * sizeof(double);
+        size_t Fixed = Memory.Total() - (Memory.ScratchFile ? min(MemoryBudget, Skyline) : Skyline);
+        size_t Column = (size_t)StiffnessMatrix->GetMaximumHalfBandwidth() * sizeof(double);
+
+        if (Fixed < MemoryLimit && MemoryLimit - Fixed >= 4 * Column)
+        {
+            cerr << "*** Warning *** The LDLT solver needs " << Memory.Total() / 1048576 << " MB, more than "
+                 << "the memory limit, and the stiffness matrix is stored out of core !" << endl;
+
+            MemoryBudget = MemoryLimit - Fixed;
+            Memory = CalculateMemory(SkylineLDLT, MemoryBudget);
+
+            return true;
+        }
+
+        //    Use the PCG solver otherwise
+        CMemoryEstimate Iterative = CalculateMemory(SparsePCG, 0);
+
+        if (Iterative.Total() <= MemoryLimit)
+        {
+            cerr << "*** Warning *** The LDLT solver needs " << Memory.Total() / 1048576 << " MB, more than "
+                 << "the memory limit, and the PCG solver is used !" << endl;
+
+            delete StiffnessMatrix;
+            StiffnessMatrix = nullptr;
+
+            SolverType = SparsePCG;
+            Memory = Iterative;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
 //    Allocate storage for matrices Force, ColumnHeights, DiagonalAddress and StiffnessMatrix
 //    and calculate the column heights and address of diagonal elements
 void CDomain::AllocateMatrices()
 {
+    CProfileScope Scope("CDomain::AllocateMatrices");
+
+    //    Pre-flight: the memory of the solution is checked before the matrices are allocated
+    if (!EstimateMemory())
+    {
+        cerr << "*** Error *** Not enough memory for the solution within the memory limit !" << endl
+             << "    REQUIRED = " << Memory.Total() / 1048576 << " MB, LIMIT = " << MemoryLimit / 1048576 << " MB" << endl;
+
+        exit(6);
+    }
+
     //    Allocate for global force/displacement vector
     Force = new double[NEQ];
-    
-    //  Create the banded stiffness matrix
-    StiffnessMatrix = new CSkylineMatrix<double>(NEQ);
-    
-    //    Calculate column heights
-    CalculateColumnHeights();
-    
-    //    Calculate address of diagonal elements in banded matrix
-    StiffnessMatrix->CalculateDiagnoalAddress();
-    
-    //    Allocate for banded global stiffness matrix
-    StiffnessMatrix->Allocate();
+
+    if (SolverType == SparsePCG)
+    {
+        //  Create the sparse stiffness matrix and calculate its sparsity pattern
+        SparseStiffnessMatrix = new CSparseMatrix<double>(NEQ);
+        CalculateSparsity();
+    }
+    else
+    {
+        //    Allocate for banded global stiffness matrix, in a scratch file when a memory budget is given
+        if (!MemoryBudget)
+            StiffnessMatrix->Allocate();
+        else
+        {
+            const char* Directory = getenv("TMPDIR");
+            if (!Directory || !*Directory)
+                Directory = ".";
+
+            if (!StiffnessMatrix->AllocateOutOfCore(Directory))
+            {
+                cerr << "*** Warning *** Scratch file of the stiffness matrix cannot be created in " << Directory
+                     << ", the matrix is stored in core !" << endl;
+
+                StiffnessMatrix->Allocate();
+            }
+        }
+
+        //    Allocate for the force/displacement vectors of a block of load cases
+        ForceBlock = new double[(size_t)NEQ * min(NLCASE, NRHS)];
+    }
     
     COutputter* Output = COutputter::GetInstance();
     Output->OutputTotalSystemData();
 }
 
 //	Assemble the banded gloabl stiffness matrix
-void CDomain::AssembleStiffnessMatrix()
+void CDomain::AssembleStiffnessMatrix(unsigned int FirstColumn)
 {
+	CProfileScope Scope("CDomain::AssembleStiffnessMatrix");
+
+//	Clear the columns assembled again, block by block for an out of core matrix
+	if (FirstColumn > 1)
+	{
+		size_t BlockEntries = IsOutOfCore() ? max(MemoryBudget / 2 / sizeof(double), (size_t)1) : SIZE_MAX;
+		size_t* DiagonalAddress = StiffnessMatrix->GetDiagonalAddress();
+
+		for (unsigned int First = FirstColumn, j = FirstColumn; j <= NEQ; j++)
+			if (j == NEQ || DiagonalAddress[j + 1] - DiagonalAddress[First - 1] > BlockEntries)
+			{
+				StiffnessMatrix->Clear(First, j);
+				StiffnessMatrix->Release(First, j);
+				First = j + 1;
+			}
+	}
+
+//	An element is assembled again if it has an equation in the columns FirstColumn:NEQ
+	auto Affected = [FirstColumn](CElementGroup& ElementGrp, unsigned int Ele)
+	{
+		const unsigned int* LocationMatrix = ElementGrp.GetLocationMatrix(Ele);
+		return *max_element(LocationMatrix, LocationMatrix + ElementGrp.GetND()) >= FirstColumn;
+	};
+
 //	Loop over for all element groups
 	for (unsigned int EleGrp = 0; EleGrp < NUMEG; EleGrp++)
 	{
         CElementGroup& ElementGrp = EleGrpList[EleGrp];
-        unsigned int NUME = ElementGrp.GetNUME();
 
-		unsigned int size = ElementGrp[0].SizeOfStiffnessMatrix();
-		double* Matrix = new double[size];
+        unsigned int ND = ElementGrp.GetND();
+		unsigned int size = ND * (ND + 1) / 2;
 
-//		Loop over for all elements in group EleGrp
-		for (unsigned int Ele = 0; Ele < NUME; Ele++)
+//		An out of core matrix is written back to its scratch file after every Batch elements,
+//		which touch at most two pages per degree of freedom, to keep it within half the budget
+		unsigned int Batch = UINT_MAX;
+		if (IsOutOfCore())
+			Batch = (unsigned int)min(max(MemoryBudget / 2 / (2 * ND * CMappedFile::PageSize()), (size_t)1),
+									  (size_t)UINT_MAX);
+
+//      Elements of the same color never add to the same entry of the stiffness matrix,
+//      so they are assembled concurrently. The colors are assembled one after another, also
+//      by a single thread, which fixes the order of the sums independently of the number of threads.
+        vector<unsigned int> ColorStart, Elements;
+        ColorElements(ElementGrp, ColorStart, Elements);
+
+//      Keep the affected elements of each color in their order
+        if (FirstColumn > 1)
         {
-            CElement& Element = ElementGrp[Ele];
-            Element.ElementStiffness(Matrix);
-            StiffnessMatrix->Assembly(Matrix, Element.GetLocationMatrix(), Element.GetND());
+            unsigned int Kept = 0;
+            for (unsigned int c = 0; c + 1 < ColorStart.size(); c++)
+            {
+                unsigned int Begin = Kept;
+                for (unsigned int i = ColorStart[c]; i < ColorStart[c+1]; i++)
+                    if (Affected(ElementGrp, Elements[i]))
+                        Elements[Kept++] = Elements[i];
+
+                ColorStart[c] = Begin;
+            }
+
+            ColorStart.back() = Kept;
+            Elements.resize(Kept);
         }
 
-		delete[] Matrix;
-		Matrix = nullptr;
+        for (unsigned int c = 0; c + 1 < ColorStart.size(); c++)
+            for (unsigned int First = ColorStart[c]; First < ColorStart[c+1]; First += min(Batch, ColorStart[c+1] - First))
+            {
+                CParallel::For(First, First + min(Batch, ColorStart[c+1] - First),
+                               [&](unsigned int Begin, unsigned int End, unsigned int)
+                {
+                    vector<double> Matrices((size_t)CElementGroup::BatchSize * size);
+
+                    for (unsigned int i = Begin; i < End; i += CElementGroup::BatchSize)
+                    {
+                        unsigned int Count = min(CElementGroup::BatchSize, End - i);
+                        ElementGrp.ComputeStiffnessBatch(&Elements[i], Count, Matrices.data());
+
+                        for (unsigned int j = 0; j < Count; j++)
+                            AssembleElementStiffness(Matrices.data() + (size_t)j * size,
+                                                     ElementGrp.GetLocationMatrix(Elements[i + j]), ND, FirstColumn);
+                    }
+                });
+
+                if (IsOutOfCore())
+                    StiffnessMatrix->Release(1, NEQ);
+            }
 	}
 
+//	Write the rest of the assembled matrix back to the scratch file of an out of core matrix,
+//	so that the factorization starts with an empty window
+	if (IsOutOfCore())
+		StiffnessMatrix->Release(1, NEQ);
+
 #ifdef _DEBUG_
 	COutputter* Output = COutputter::GetInstance();
-	Output->PrintStiffnessMatrix();
+	if (StiffnessMatrix)
+		Output->PrintStiffnessMatrix();
 #endif
 
 }
 
+//	Assemble the element stiffness matrix to the global stiffness matrix of the selected solver
+void CDomain::AssembleElementStiffness(double* Matrix, unsigned int* LocationMatrix, unsigned int ND,
+									   unsigned int FirstColumn)
+{
+	if (StiffnessMatrix)
+		StiffnessMatrix->Assembly(Matrix, LocationMatrix, ND, FirstColumn);
+	else
+		SparseStiffnessMatrix->Assembly(Matrix, LocationMatrix, ND);
+}
+
+//	Color the elements of a group such that no two elements of the same color share a global equation
+//	Greedy coloring in element order. Each pass handles 64 colors with a bit mask per equation.
+void CDomain::ColorElements(CElementGroup& ElementGrp, vector<unsigned int>& ColorStart, vector<unsigned int>& Elements)
+{
+    unsigned int NUME = ElementGrp.GetNUME();
+
+    vector<unsigned int> Color(NUME, UINT_MAX);
+    vector<unsigned long long> UsedColors(NEQ);
+
+    unsigned int NumberOfColors = 0;
+    unsigned int Uncolored = NUME;
+
+    for (unsigned int Pass = 0; Uncolored; Pass++)
+    {
+        fill(UsedColors.begin(), UsedColors.end(), 0ULL);
+
+        for (unsigned int Ele = 0; Ele < NUME; Ele++)
+        {
+            if (Color[Ele] != UINT_MAX)
+                continue;
+
+            unsigned int* LocationMatrix = ElementGrp.GetLocationMatrix(Ele);
+            unsigned int ND = ElementGrp.GetND();
+
+            unsigned long long Used = 0;
+            for (unsigned int i = 0; i < ND; i++)
+                if (LocationMatrix[i])
+                    Used |= UsedColors[LocationMatrix[i] - 1];
+
+            if (Used == ~0ULL)    // All colors of this pass are taken by neighbours
+                continue;
+
+            unsigned int c = 0;
+            while (Used & (1ULL << c))
+                c++;
+
+            for (unsigned int i = 0; i < ND; i++)
+                if (LocationMatrix[i])
+                    UsedColors[LocationMatrix[i] - 1] |= 1ULL << c;
+
+            Color[Ele] = 64*Pass + c;
+            NumberOfColors = max(NumberOfColors, Color[Ele] + 1);
+            Uncolored--;
+        }
+    }
+
+//  Sort the elements by color, keeping the element order within each color
+    ColorStart.assign(NumberOfColors + 1, 0);
+    for (unsigned int Ele = 0; Ele < NUME; Ele++)
+        ColorStart[Color[Ele] + 1]++;
+
+    for (unsigned int c = 0; c < NumberOfColors; c++)
+        ColorStart[c + 1] += ColorStart[c];
+
+    vector<unsigned int> Next(ColorStart.begin(), ColorStart.end() - 1);
+
+    Elements.resize(NUME);
+    for (unsigned int Ele = 0; Ele < NUME; Ele++)
+        Elements[Next[Color[Ele]]++] = Ele;
+}
+
 //	Assemble the global nodal force vector for load case LoadCase
 bool CDomain::AssembleForce(unsigned int LoadCase)
 {
+	CProfileScope Scope("CDomain::AssembleForce");
+
 	if (LoadCase > NLCASE) 
 		return false;
 
@@ -315,3 +1416,46 @@ bool CDomain::AssembleForce(unsigned int LoadCase)
 	return true;
 }
 
+
+//	Assemble the global nodal force vectors of load cases FirstLoadCase ... FirstLoadCase+NumberOfCases-1
+bool CDomain::AssembleForceBlock(unsigned int FirstLoadCase, unsigned int NumberOfCases)
+{
+	CProfileScope Scope("CDomain::AssembleForceBlock");
+
+	if (FirstLoadCase + NumberOfCases - 1 > NLCASE)
+		return false;
+
+	clear(ForceBlock, (size_t)NEQ * NumberOfCases);
+
+	for (unsigned int k = 0; k < NumberOfCases; k++)
+	{
+		CLoadCaseData* LoadData = &LoadCases[FirstLoadCase + k - 1];
+
+//		Loop over for all concentrated loads in this load case
+		for (unsigned int lnum = 0; lnum < LoadData->nloads; lnum++)
+		{
+			unsigned int dof = NodeList[LoadData->node[lnum] - 1].bcode[LoadData->dof[lnum] - 1];
+
+			if(dof) // The DOF is activated
+				ForceBlock[(size_t)(dof - 1) * NumberOfCases + k] += LoadData->load[lnum];
+		}
+	}
+
+	return true;
+}
+
+//	Copy the displacement of the k-th load case of ForceBlock to the global nodal displacement vector
+void CDomain::ExtractDisplacement(unsigned int k, unsigned int NumberOfCases)
+{
+	for (unsigned int i = 0; i < NEQ; i++)
+		Force[i] = ForceBlock[(size_t)i * NumberOfCases + k];
+}
+
+//	Calculate the stresses of all elements for the global nodal displacement vector
+void CDomain::CalculateStresses()
+{
+	CProfileScope Scope("CDomain::CalculateStresses");
+
+	for (unsigned int EleGrp = 0; EleGrp < NUMEG; EleGrp++)
+		EleGrpList[EleGrp].CalculateStresses(Force);
+}
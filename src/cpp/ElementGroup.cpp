@@ -10,17 +10,24 @@
 
 #include "ElementGroup.h"
 #include "Domain.h"
+#include "Kernels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cmath>
 
 CNode* CElementGroup::NodeList_ = nullptr;
+double* CElementGroup::Coordinates_ = nullptr;
+
+const unsigned int CElementGroup::BatchSize;
 
 //! Constructor
 CElementGroup::CElementGroup()
 {
-    if (!NodeList_)
-    {
-        CDomain* FEMData = CDomain::GetInstance();
-        NodeList_ = FEMData->GetNodeList();
-    }
+//  The nodes of the current domain, which may replace a deleted one
+    CDomain* FEMData = CDomain::GetInstance();
+    NodeList_ = FEMData->GetNodeList();
+    Coordinates_ = FEMData->GetCoordinates();
     
     ElementType_ = ElementTypes::UNDEFINED;
     
@@ -29,16 +36,36 @@ CElementGroup::CElementGroup()
     
     NUMMAT_ = 0;
     MaterialList_ = nullptr;
+
+    NEN_ = 0;
+    ND_ = 0;
+    NCOL_ = 0;
+    NodePointers_ = nullptr;
+    Connectivity_ = nullptr;
+    MaterialSets_ = nullptr;
+    LocationMatrices_ = nullptr;
+    Stresses_ = nullptr;
 }
 
 //! Deconstructor
 CElementGroup::~CElementGroup()
 {
-    if (ElementList_)
-        delete [] ElementList_;
-    
-    if (MaterialList_)
-        delete [] MaterialList_;
+//  The arrays are deleted as the derived classes they were allocated with
+    switch (ElementType_)
+    {
+        case ElementTypes::Bar:
+            delete [] static_cast<CBar*>(ElementList_);
+            delete [] static_cast<CBarMaterial*>(MaterialList_);
+            break;
+        default:
+            break;
+    }
+
+    delete [] NodePointers_;
+    delete [] Connectivity_;
+    delete [] MaterialSets_;
+    delete [] LocationMatrices_;
+    delete [] Stresses_;
 }
 
 //! operator []
@@ -65,6 +92,9 @@ void CElementGroup::CalculateMemberSize()
         case ElementTypes::Bar:
             ElementSize_ = sizeof(CBar);
             MaterialSize_ = sizeof(CBarMaterial);
+            NEN_ = 2;
+            ND_ = 6;
+            NCOL_ = 2;  // Force and stress
             break;
         default:
             std::cerr << "Type " << ElementType_ << " not available. See CElementGroup::CalculateMemberSize." << std::endl;
@@ -85,6 +115,19 @@ void CElementGroup::AllocateElements(std::size_t size)
             std::cerr << "Type " << ElementType_ << " not available. See CElementGroup::AllocateElement." << std::endl;
             exit(5);
     }
+
+    NodePointers_ = new CNode*[size * NEN_];
+    Connectivity_ = new unsigned int[size * NEN_];
+    MaterialSets_ = new unsigned int[size];
+    LocationMatrices_ = new unsigned int[size * ND_];
+    Stresses_ = new double[size * NCOL_];
+
+    for (std::size_t Ele = 0; Ele < size; Ele++)
+    {
+        CElement& Element = (*this)[(unsigned int)Ele];
+        Element.SetNodes(NodePointers_ + Ele * NEN_);
+        Element.SetLocationMatrix(LocationMatrices_ + Ele * ND_);
+    }
 }
 
 //! Allocate array of derived materials
@@ -101,10 +144,294 @@ void CElementGroup::AllocateMaterials(std::size_t size)
     }
 }
 
+//! Store the nodes and material sets of the elements in Connectivity_ and MaterialSets_
+void CElementGroup::StoreConnectivity()
+{
+    for (unsigned int Ele = 0; Ele < NUME_; Ele++)
+    {
+        CElement& Element = (*this)[Ele];
+        CNode** Nodes = Element.GetNodes();
+
+        for (unsigned int N = 0; N < NEN_; N++)
+            Connectivity_[(std::size_t)Ele * NEN_ + N] = (unsigned int)(Nodes[N] - NodeList_);
+
+        MaterialSets_[Ele] = (unsigned int)(((char*)Element.GetElementMaterial() - (char*)MaterialList_) / MaterialSize_);
+    }
+}
+
+//! Return the bytes of the element and material objects and of the flat arrays of the group
+std::size_t CElementGroup::GetMemorySize()
+{
+    std::size_t PerElement = ElementSize_ + NEN_ * (sizeof(CNode*) + sizeof(unsigned int)) + sizeof(unsigned int)
+                           + ND_ * sizeof(unsigned int) + NCOL_ * sizeof(double);
+
+    return NUME_ * PerElement + NUMMAT_ * MaterialSize_;
+}
+
+//! Generate the location matrices of all elements from the equation numbers of their nodes
+//  Caution:  Equation number is numbered from 1 !
+void CElementGroup::GenerateLocationMatrices()
+{
+    for (unsigned int Ele = 0; Ele < NUME_; Ele++)
+    {
+        const unsigned int* Nodes = GetConnectivity(Ele);
+        unsigned int* LocationMatrix = GetLocationMatrix(Ele);
+
+        unsigned int i = 0;
+        for (unsigned int N = 0; N < NEN_; N++)
+            for (unsigned int D = 0; D < CNode::NDF; D++)
+                LocationMatrix[i++] = NodeList_[Nodes[N]].bcode[D];
+    }
+}
+
+//! Kernels of an element type without kernels on the flat arrays: call the element object
+template <ElementTypes Type_>
+void CElementKernel<Type_>::Stiffness(CElementGroup& Group, unsigned int Ele, double* Matrix)
+{
+    Group[Ele].ElementStiffness(Matrix);
+}
+
+template <ElementTypes Type_>
+void CElementKernel<Type_>::Stress(CElementGroup& Group, unsigned int Ele, double* Displacement, double* Stress)
+{
+    Group[Ele].ElementStress(Stress, Displacement);
+}
+
+template <ElementTypes Type_>
+void CElementKernel<Type_>::StressBatch(CElementGroup& Group, unsigned int First, unsigned int Count, double* Displacement,
+                                       double* Stresses)
+{
+    for (unsigned int i = 0; i < Count; i++)
+        Stress(Group, First + i, Displacement, Stresses + (std::size_t)i * Group.GetNCOL());
+}
+
+template <ElementTypes Type_>
+template <class Index_>
+void CElementKernel<Type_>::StiffnessBatch(CElementGroup& Group, Index_ Element, unsigned int Count, double* Matrices)
+{
+    std::size_t size = Group.GetND() * (Group.GetND() + 1) / 2;
+
+    for (unsigned int i = 0; i < Count; i++)
+        Stiffness(Group, Element(i), Matrices + i * size);
+}
+
+//! Kernels of the bar element
+template <>
+struct CElementKernel<ElementTypes::Bar>
+{
+    static void Stiffness(CElementGroup& Group, unsigned int Ele, double* Matrix)
+    {
+        const unsigned int* Nodes = Group.GetConnectivity(Ele);
+
+        CBar::Stiffness(Group.Coordinates_ + 3 * (std::size_t)Nodes[0], Group.Coordinates_ + 3 * (std::size_t)Nodes[1],
+                        static_cast<CBarMaterial*>(Group.MaterialList_)[Group.MaterialSets_[Ele]], Matrix);
+    }
+
+//  Force and stress
+    static void Stress(CElementGroup& Group, unsigned int Ele, double* Displacement, double* Stress)
+    {
+        const unsigned int* Nodes = Group.GetConnectivity(Ele);
+        const CBarMaterial& Material = static_cast<CBarMaterial*>(Group.MaterialList_)[Group.MaterialSets_[Ele]];
+
+        double stress = CBar::Stress(Group.Coordinates_ + 3 * (std::size_t)Nodes[0], Group.Coordinates_ + 3 * (std::size_t)Nodes[1],
+                                     Material, Group.GetLocationMatrix(Ele), Displacement);
+
+        Stress[0] = stress * Material.Area;
+        Stress[1] = stress;
+    }
+
+//  The coordinate differences and the axial stiffness E*A of up to BatchSize bars are gathered
+//  into contiguous arrays, and the matrices are calculated by the vectorized kernel
+    template <class Index_>
+    static void StiffnessBatch(CElementGroup& Group, Index_ Element, unsigned int Count, double* Matrices)
+    {
+        double DX[CElementGroup::BatchSize], DY[CElementGroup::BatchSize], DZ[CElementGroup::BatchSize];
+        double EA[CElementGroup::BatchSize];
+
+        for (unsigned int First = 0; First < Count; First += CElementGroup::BatchSize)
+        {
+            unsigned int n = min(CElementGroup::BatchSize, Count - First);
+
+            for (unsigned int i = 0; i < n; i++)
+            {
+                unsigned int Ele = Element(First + i);
+                const unsigned int* Nodes = Group.GetConnectivity(Ele);
+                const double* XYZ1 = Group.Coordinates_ + 3 * (std::size_t)Nodes[0];
+                const double* XYZ2 = Group.Coordinates_ + 3 * (std::size_t)Nodes[1];
+                const CBarMaterial& Material = static_cast<CBarMaterial*>(Group.MaterialList_)[Group.MaterialSets_[Ele]];
+
+                DX[i] = XYZ2[0] - XYZ1[0];
+                DY[i] = XYZ2[1] - XYZ1[1];
+                DZ[i] = XYZ2[2] - XYZ1[2];
+                EA[i] = Material.E * Material.Area;
+            }
+
+            CKernels::BarStiffness(DX, DY, DZ, EA, n, Matrices + 21 * (std::size_t)First);
+        }
+
+#ifdef _DEBUG_
+//      The vectorized kernel must reproduce the scalar stiffness matrices bit for bit
+        for (unsigned int i = 0; i < Count; i++)
+        {
+            double Matrix[21];
+            Stiffness(Group, Element(i), Matrix);
+
+            if (memcmp(Matrix, Matrices + 21 * (std::size_t)i, sizeof(Matrix)))
+            {
+                cerr << "*** Error *** The " << CKernels::GetLevelName(CKernels::GetLevel())
+                     << " stiffness matrix of bar element " << Element(i) + 1 << " differs from CBar::Stiffness !" << endl;
+                exit(5);
+            }
+        }
+#endif
+    }
+
+//  The coordinate differences, Young's moduli and displacements of up to BatchSize bars are
+//  gathered into contiguous arrays, and the stresses are calculated by the vectorized kernel
+    static void StressBatch(CElementGroup& Group, unsigned int First, unsigned int Count, double* Displacement,
+                            double* Stresses)
+    {
+        double DX[CElementGroup::BatchSize], DY[CElementGroup::BatchSize], DZ[CElementGroup::BatchSize];
+        double E[CElementGroup::BatchSize], U[6 * CElementGroup::BatchSize], stress[CElementGroup::BatchSize];
+
+        for (unsigned int Begin = 0; Begin < Count; Begin += CElementGroup::BatchSize)
+        {
+            unsigned int n = min(CElementGroup::BatchSize, Count - Begin);
+
+            for (unsigned int i = 0; i < n; i++)
+            {
+                unsigned int Ele = First + Begin + i;
+                const unsigned int* Nodes = Group.GetConnectivity(Ele);
+                const unsigned int* LocationMatrix = Group.GetLocationMatrix(Ele);
+                const double* XYZ1 = Group.Coordinates_ + 3 * (std::size_t)Nodes[0];
+                const double* XYZ2 = Group.Coordinates_ + 3 * (std::size_t)Nodes[1];
+
+                DX[i] = XYZ2[0] - XYZ1[0];
+                DY[i] = XYZ2[1] - XYZ1[1];
+                DZ[i] = XYZ2[2] - XYZ1[2];
+                E[i] = static_cast<CBarMaterial*>(Group.MaterialList_)[Group.MaterialSets_[Ele]].E;
+
+                for (unsigned int j = 0; j < 6; j++)
+                    U[j * n + i] = LocationMatrix[j] ? Displacement[LocationMatrix[j] - 1] : 0.0;
+            }
+
+            CKernels::BarStress(DX, DY, DZ, E, U, n, stress);
+
+//          The kernel adds the zero terms of the fixed degrees of freedom, which change the result
+//          only if it is not finite, e.g. for a bar of zero length. Such bars are recalculated
+            for (unsigned int i = 0; i < n; i++)
+            {
+                unsigned int Ele = First + Begin + i;
+                double* Columns = Stresses + 2 * (std::size_t)(Begin + i);
+
+                if (std::isfinite(stress[i]))
+                {
+                    Columns[0] = stress[i] * static_cast<CBarMaterial*>(Group.MaterialList_)[Group.MaterialSets_[Ele]].Area;
+                    Columns[1] = stress[i];
+                }
+                else
+                    Stress(Group, Ele, Displacement, Columns);
+            }
+        }
+
+#ifdef _DEBUG_
+//      The vectorized kernel must reproduce the scalar stresses bit for bit
+        for (unsigned int i = 0; i < Count; i++)
+        {
+            double Columns[2];
+            Stress(Group, First + i, Displacement, Columns);
+
+            if (memcmp(Columns, Stresses + 2 * (std::size_t)i, sizeof(Columns)))
+            {
+                cerr << "*** Error *** The " << CKernels::GetLevelName(CKernels::GetLevel())
+                     << " stress of bar element " << First + i + 1 << " differs from CBar::Stress !" << endl;
+                exit(5);
+            }
+        }
+#endif
+    }
+};
+
+//! Calculate the stiffness matrices of elements First ... First+Count-1 from the flat arrays of the group
+void CElementGroup::ComputeStiffnessBatch(unsigned int First, unsigned int Count, double* Matrices)
+{
+    auto Element = [First](unsigned int i) { return First + i; };
+
+    switch (ElementType_)
+    {
+        case ElementTypes::Bar:
+            CElementKernel<ElementTypes::Bar>::StiffnessBatch(*this, Element, Count, Matrices);
+            break;
+        default:
+            CElementKernel<ElementTypes::UNDEFINED>::StiffnessBatch(*this, Element, Count, Matrices);
+            break;
+    }
+}
+
+//! Calculate the stiffness matrices of elements Elements[0] ... Elements[Count-1]
+void CElementGroup::ComputeStiffnessBatch(const unsigned int* Elements, unsigned int Count, double* Matrices)
+{
+    auto Element = [Elements](unsigned int i) { return Elements[i]; };
+
+    switch (ElementType_)
+    {
+        case ElementTypes::Bar:
+            CElementKernel<ElementTypes::Bar>::StiffnessBatch(*this, Element, Count, Matrices);
+            break;
+        default:
+            CElementKernel<ElementTypes::UNDEFINED>::StiffnessBatch(*this, Element, Count, Matrices);
+            break;
+    }
+}
+
+//! Calculate the stiffness matrix of an element with the nodes Nodes and the material properties Properties
+void CElementGroup::ComputeStiffness(const unsigned int* Nodes, const double* Properties, double* Matrix)
+{
+    switch (ElementType_)
+    {
+        case ElementTypes::Bar:
+        {
+            CBarMaterial Material;
+            Material.SetProperties(Properties);
+
+            CBar::Stiffness(Coordinates_ + 3 * (std::size_t)Nodes[0], Coordinates_ + 3 * (std::size_t)Nodes[1], Material, Matrix);
+            break;
+        }
+        default:
+            std::cerr << "Type " << ElementType_ << " not available. See CElementGroup::ComputeStiffness." << std::endl;
+            exit(5);
+    }
+}
+
+//! Calculate the stresses of elements First ... First+Count-1
+void CElementGroup::ComputeStressBatch(unsigned int First, unsigned int Count, double* Displacement, double* Stresses)
+{
+    switch (ElementType_)
+    {
+        case ElementTypes::Bar:
+            CElementKernel<ElementTypes::Bar>::StressBatch(*this, First, Count, Displacement, Stresses);
+            break;
+        default:
+            CElementKernel<ElementTypes::UNDEFINED>::StressBatch(*this, First, Count, Displacement, Stresses);
+            break;
+    }
+}
+
+//! Calculate the stresses of all elements into the stress array of the group, on all threads
+void CElementGroup::CalculateStresses(double* Displacement)
+{
+    CParallel::For(0, NUME_, [this, Displacement](unsigned int Begin, unsigned int End, unsigned int)
+    {
+        ComputeStressBatch(Begin, End - Begin, Displacement, Stresses_ + (std::size_t)Begin * NCOL_);
+    });
+}
+
 //! Read element group data from stream Input
-bool CElementGroup::Read(ifstream& Input)
+bool CElementGroup::Read(CTokenizer& Input)
 {
-    Input >> (int&)ElementType_ >> NUME_ >> NUMMAT_;
+    int Type;
+    Input >> Type >> NUME_ >> NUMMAT_;
+    ElementType_ = (ElementTypes)Type;
     
     CalculateMemberSize();
 
@@ -128,6 +455,19 @@ bool CElementGroup::Read(ifstream& Input)
 
 //  Read element data lines
     AllocateElements(NUME_);
+
+//  Read the element lines on all threads, checking the order of the elements
+    if (Input.ReadLines(NUME_, [this](CTokenizer& Chunk, unsigned int Ele)
+        {
+            unsigned int N = 0;
+            Chunk >> N;    // element number
+
+            return N == Ele + 1 && (*this)[Ele].Read(Chunk, MaterialList_, NodeList_);
+        }))
+    {
+        StoreConnectivity();
+        return true;
+    }
     
 //  Loop over for all elements in this element group
     for (unsigned int Ele = 0; Ele < NUME_; Ele++)
@@ -149,5 +489,105 @@ bool CElementGroup::Read(ifstream& Input)
             return false;
     }
 
+    StoreConnectivity();
+
+    return true;
+}
+
+//! Read element group data from the binary input data file Deck
+bool CElementGroup::Read(CBinaryDeck& Deck)
+{
+    const unsigned int* Header = Deck.Read<unsigned int>(5);    // ElementType, NUME, NUMMAT, NEN, NPROP
+    if (!Header)
+        return false;
+
+    ElementType_ = (ElementTypes)Header[0];
+    NUME_ = Header[1];
+    NUMMAT_ = Header[2];
+
+    CalculateMemberSize();
+
+    AllocateMaterials(NUMMAT_);
+    AllocateElements(NUME_);
+
+    unsigned int NEN = NUME_ ? (*this)[0].GetNEN() : Header[3];
+    unsigned int NPROP = NUMMAT_ ? GetMaterial(0).GetNumberOfProperties() : Header[4];
+
+    if (Header[3] != NEN || Header[4] != NPROP)
+    {
+        cerr << "*** Error *** Element group of type " << ElementType_ << " has " << Header[3]
+             << " nodes per element and " << Header[4] << " material properties in the binary file !" << endl;
+
+        return false;
+    }
+
+//  Material/section property sets
+    const double* Properties = Deck.Read<double>((size_t)NUMMAT_ * NPROP);
+    if (!Properties)
+        return false;
+
+    for (unsigned int mset = 0; mset < NUMMAT_; mset++)
+    {
+        GetMaterial(mset).nset = mset + 1;
+        GetMaterial(mset).SetProperties(Properties + (size_t)mset * NPROP);
+    }
+
+//  Nodes and material set of each element
+    const unsigned int* Connectivity = Deck.Read<unsigned int>((size_t)NUME_ * (NEN + 1));
+    if (!Connectivity)
+        return false;
+
+    unsigned int NUMNP = CDomain::GetInstance()->GetNUMNP();
+
+    for (unsigned int Ele = 0; Ele < NUME_; Ele++)
+    {
+        const unsigned int* Nodes = Connectivity + (size_t)Ele * (NEN + 1);
+        unsigned int MSet = Nodes[NEN];
+
+        bool Valid = MSet >= 1 && MSet <= NUMMAT_;
+        for (unsigned int N = 0; N < NEN; N++)
+            Valid = Valid && Nodes[N] >= 1 && Nodes[N] <= NUMNP;
+
+        if (!Valid)
+        {
+            cerr << "*** Error *** Invalid node or material set number in element " << Ele + 1 << " !" << endl;
+            return false;
+        }
+
+        (*this)[Ele].Connect(Nodes, &GetMaterial(MSet - 1), NodeList_);
+    }
+
+    StoreConnectivity();
+
     return true;
 }
+
+//! Write element group data to the binary input data file Deck
+void CElementGroup::Write(CBinaryDeck& Deck)
+{
+    unsigned int NEN = NUME_ ? (*this)[0].GetNEN() : 0;
+    unsigned int NPROP = NUMMAT_ ? GetMaterial(0).GetNumberOfProperties() : 0;
+
+    unsigned int Header[5] = {(unsigned int)ElementType_, NUME_, NUMMAT_, NEN, NPROP};
+    Deck.Write(Header, 5);
+
+    vector<double> Properties((size_t)NUMMAT_ * NPROP);
+    for (unsigned int mset = 0; mset < NUMMAT_; mset++)
+        GetMaterial(mset).GetProperties(Properties.data() + (size_t)mset * NPROP);
+
+    Deck.Write(Properties.data(), Properties.size());
+
+    vector<unsigned int> Connectivity((size_t)NUME_ * (NEN + 1));
+    for (unsigned int Ele = 0; Ele < NUME_; Ele++)
+    {
+        CElement& Element = (*this)[Ele];
+        unsigned int* Nodes = Connectivity.data() + (size_t)Ele * (NEN + 1);
+
+        for (unsigned int N = 0; N < NEN; N++)
+            Nodes[N] = Element.GetNodes()[N]->NodeNumber;
+
+        Nodes[NEN] = Element.GetElementMaterial()->nset;
+    }
+
+    Deck.Write(Connectivity.data(), Connectivity.size());
+}
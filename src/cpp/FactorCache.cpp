@@ -0,0 +1,209 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#include "FactorCache.h"
+#include "Profiler.h"
+
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+
+const size_t CFactorCache::BlockSize;
+
+//	Size of the header in bytes : magic, version, byte order, key, node key, NEQ, padding, NWK, size of the
+//	element records
+static const size_t HeaderSize = 8 + 2 * 4 + 2 * 8 + 2 * 4 + 2 * 8;
+
+//	Fields of the header of a cache file
+struct CCacheHeader
+{
+	uint64_t Key, NodeKey, NWK, RecordSize;
+	unsigned int NEQ;
+};
+
+//	Read and check the header of the cache file Input
+static bool ReadHeader(ifstream& Input, CCacheHeader& Header)
+{
+	char Data[HeaderSize];
+	if (!Input.read(Data, HeaderSize))
+		return false;
+
+	unsigned int Version, ByteOrder;
+	memcpy(&Version, Data + 8, 4);
+	memcpy(&ByteOrder, Data + 12, 4);
+	memcpy(&Header.Key, Data + 16, 8);
+	memcpy(&Header.NodeKey, Data + 24, 8);
+	memcpy(&Header.NEQ, Data + 32, 4);
+	memcpy(&Header.NWK, Data + 40, 8);
+	memcpy(&Header.RecordSize, Data + 48, 8);
+
+	return !memcmp(Data, CFactorCache::Magic(), 8) && Version == CFactorCache::Version &&
+		   ByteOrder == CFactorCache::ByteOrder;
+}
+
+//	Size of the element records in the file, padded to a multiple of 8 bytes
+static uint64_t PaddedSize(uint64_t RecordSize)
+{
+	return (RecordSize + 7) / 8 * 8;
+}
+
+//	Continue the FNV-1a hash Hash with the Size bytes of Data
+uint64_t CFactorCache::FNV1a(const void* Data, size_t Size, uint64_t Hash)
+{
+	const uint64_t Prime = 1099511628211ULL;
+	const unsigned char* Bytes = (const unsigned char*)Data;
+
+	for (size_t i = 0; i < Size; i++)
+	{
+		Hash ^= Bytes[i];
+		Hash *= Prime;
+	}
+
+	return Hash;
+}
+
+//	Read the factorized matrix of key Key (or node key Key) from the cache file FileName into Matrix
+bool CFactorCache::Read(const string& FileName, uint64_t Key, CSkylineMatrix<double>& Matrix, bool NodeKey)
+{
+	CProfileScope Scope("CFactorCache::Read");
+
+	ifstream Input(FileName, ios::binary);
+	if (!Input)
+		return false;
+
+	CCacheHeader Header;
+	if (!ReadHeader(Input, Header) || (NodeKey ? Header.NodeKey : Header.Key) != Key ||
+		Header.NEQ != Matrix.dim() || Header.NWK != Matrix.size())
+		return false;
+
+	unsigned int NEQ = Header.NEQ;
+	uint64_t NWK = Header.NWK;
+
+	Input.seekg(HeaderSize + PaddedSize(Header.RecordSize));
+
+//	The skyline must be the one of Matrix
+	vector<uint64_t> DiagonalAddress(NEQ + 1);
+	if (!Input.read((char*)DiagonalAddress.data(), DiagonalAddress.size() * sizeof(uint64_t)))
+		return false;
+
+	for (unsigned int i = 0; i <= NEQ; i++)
+		if (DiagonalAddress[i] != Matrix.GetDiagonalAddress()[i])
+			return false;
+
+//	A truncated file is detected before Matrix is changed
+	streamoff Start = Input.tellg();
+	Input.seekg(0, ios::end);
+	if (Input.tellg() - Start != (streamoff)(NWK * sizeof(double)))
+		return false;
+	Input.seekg(Start);
+
+	size_t* Address = Matrix.GetDiagonalAddress();
+	bool Success = true;
+
+	ForEachBlock(Matrix, [&](unsigned int First, unsigned int Last)
+	{
+		if (Success)
+			Success = (bool)Input.read((char*)(Matrix.data() + Address[First - 1] - 1),
+									   (Address[Last] - Address[First - 1]) * sizeof(double));
+	});
+
+	if (Success)
+		return true;
+
+//	The matrix is cleared again after a read error, so that it can be assembled
+	ForEachBlock(Matrix, [&](unsigned int First, unsigned int Last)
+	{
+		memset(Matrix.data() + Address[First - 1] - 1, 0, (Address[Last] - Address[First - 1]) * sizeof(double));
+	});
+
+	return false;
+}
+
+//	Read the element records from the cache file FileName of node key NodeKey
+bool CFactorCache::ReadElements(const string& FileName, uint64_t NodeKey, vector<char>& Records)
+{
+	CProfileScope Scope("CFactorCache::ReadElements");
+
+	ifstream Input(FileName, ios::binary);
+	if (!Input)
+		return false;
+
+	CCacheHeader Header;
+	if (!ReadHeader(Input, Header) || Header.NodeKey != NodeKey)
+		return false;
+
+//	The size of the records of a truncated file is not trusted
+	Input.seekg(0, ios::end);
+	if ((uint64_t)Input.tellg() < HeaderSize + Header.RecordSize)
+		return false;
+	Input.seekg(HeaderSize);
+
+	Records.resize(Header.RecordSize);
+
+	return (bool)Input.read(Records.data(), Records.size());
+}
+
+//	Write the factorized matrix Matrix with key Key, node key NodeKey and the element records Records
+//	to the cache file FileName
+//	The file is written under a temporary name and renamed when it is complete
+bool CFactorCache::Write(const string& FileName, uint64_t Key, uint64_t NodeKey, CSkylineMatrix<double>& Matrix,
+						 const vector<char>& Records)
+{
+	CProfileScope Scope("CFactorCache::Write");
+
+	string TemporaryFile = FileName + ".tmp";
+
+	ofstream Output(TemporaryFile, ios::binary);
+	if (!Output)
+		return false;
+
+	char Header[HeaderSize] = {0};
+	unsigned int NEQ = Matrix.dim();
+	uint64_t NWK = Matrix.size();
+	uint64_t RecordSize = Records.size();
+
+	unsigned int Format[] = {Version, ByteOrder};
+
+	memcpy(Header, Magic(), 8);
+	memcpy(Header + 8, Format, 8);
+	memcpy(Header + 16, &Key, 8);
+	memcpy(Header + 24, &NodeKey, 8);
+	memcpy(Header + 32, &NEQ, 4);
+	memcpy(Header + 40, &NWK, 8);
+	memcpy(Header + 48, &RecordSize, 8);
+
+	Output.write(Header, HeaderSize);
+
+	vector<char> Padding(PaddedSize(RecordSize) - RecordSize, 0);
+	Output.write(Records.data(), Records.size());
+	Output.write(Padding.data(), Padding.size());
+
+	vector<uint64_t> DiagonalAddress(Matrix.GetDiagonalAddress(), Matrix.GetDiagonalAddress() + NEQ + 1);
+	Output.write((const char*)DiagonalAddress.data(), DiagonalAddress.size() * sizeof(uint64_t));
+
+	size_t* Address = Matrix.GetDiagonalAddress();
+
+	ForEachBlock(Matrix, [&](unsigned int First, unsigned int Last)
+	{
+		Output.write((const char*)(Matrix.data() + Address[First - 1] - 1),
+					 (Address[Last] - Address[First - 1]) * sizeof(double));
+	});
+
+	Output.close();
+
+	if (Output.fail() || rename(TemporaryFile.c_str(), FileName.c_str()))
+	{
+		remove(TemporaryFile.c_str());
+		return false;
+	}
+
+	return true;
+}
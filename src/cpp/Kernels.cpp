@@ -0,0 +1,514 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#include "Kernels.h"
+
+#include <cmath>
+
+//	The vectorized kernels are compiled for their instruction sets with function attributes,
+//	so that the rest of the program still runs on processors without them
+#if defined(__GNUC__) && defined(__x86_64__)
+#define STAP_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+//	Scalar kernels
+//	The dot products sum from the last element to the first, i.e. in the order of increasing
+//	equation numbers for the columns of the skyline
+
+static double ScalarDot(const double* a, const double* b, unsigned int n)
+{
+	double C = 0.0;
+	for (unsigned int k = n; k-- > 0; )
+		C += a[k] * b[k];
+
+	return C;
+}
+
+static double ScalarDotReverse(const double* a, const double* b, unsigned int n)
+{
+	double C = 0.0;
+	for (unsigned int k = n; k-- > 0; )
+		C += a[k] * b[n-1-k];
+
+	return C;
+}
+
+static void ScalarAxpy(double* y, double alpha, const double* x, unsigned int n)
+{
+	for (unsigned int k = 0; k < n; k++)
+		y[k] += alpha * x[k];
+}
+
+static void ScalarAxpyReverse(double* y, double alpha, const double* x, unsigned int n)
+{
+	for (unsigned int k = 0; k < n; k++)
+		y[k] += alpha * x[n-1-k];
+}
+
+//	Store the stiffness matrix of a bar from K = k*(dx^2, dy^2, dz^2, dx*dy, dy*dz, dx*dz),
+//	with k = E*A/L^3, in the order of CBar::Stiffness
+static inline void StoreBarStiffness(const double* K, double* Matrix)
+{
+	Matrix[0] = K[0];
+	Matrix[1] = K[1];
+	Matrix[2] = K[3];
+	Matrix[3] = K[2];
+	Matrix[4] = K[4];
+	Matrix[5] = K[5];
+	Matrix[6] = K[0];
+	Matrix[7] = -K[5];
+	Matrix[8] = -K[3];
+	Matrix[9] = -K[0];
+	Matrix[10] = K[1];
+	Matrix[11] = K[3];
+	Matrix[12] = -K[4];
+	Matrix[13] = -K[1];
+	Matrix[14] = -K[3];
+	Matrix[15] = K[2];
+	Matrix[16] = K[4];
+	Matrix[17] = K[5];
+	Matrix[18] = -K[2];
+	Matrix[19] = -K[4];
+	Matrix[20] = -K[5];
+}
+
+static void ScalarBarStiffness(const double* DX, const double* DY, const double* DZ, const double* EA,
+							   unsigned int n, double* Matrices)
+{
+	for (unsigned int i = 0; i < n; i++)
+	{
+		double DX2[6] = {DX[i] * DX[i], DY[i] * DY[i], DZ[i] * DZ[i], DX[i] * DY[i], DY[i] * DZ[i], DX[i] * DZ[i]};
+
+		double L2 = DX2[0] + DX2[1] + DX2[2];
+		double k = EA[i] / sqrt(L2) / L2;
+
+		double K[6];
+		for (unsigned int j = 0; j < 6; j++)
+			K[j] = k * DX2[j];
+
+		StoreBarStiffness(K, Matrices + 21 * (size_t)i);
+	}
+}
+
+//	The terms of the fixed degrees of freedom, which CBar::Stress skips, are +-0 and do not change
+//	the sum, which starts from +0 and thus never becomes -0
+//	Stress of the i-th bar
+static inline double SingleBarStress(const double* DX, const double* DY, const double* DZ, const double* E,
+									 const double* U, unsigned int n, unsigned int i)
+{
+	double L2 = DX[i] * DX[i] + DY[i] * DY[i] + DZ[i] * DZ[i];
+	double S[3] = {-DX[i] * E[i] / L2, -DY[i] * E[i] / L2, -DZ[i] * E[i] / L2};
+
+	double stress = 0.0;
+	for (unsigned int j = 0; j < 3; j++)
+		stress += S[j] * U[j * n + i];
+	for (unsigned int j = 0; j < 3; j++)
+		stress += -S[j] * U[(j + 3) * n + i];
+
+	return stress;
+}
+
+static void ScalarBarStress(const double* DX, const double* DY, const double* DZ, const double* E,
+							const double* U, unsigned int n, double* Stress)
+{
+	for (unsigned int i = 0; i < n; i++)
+		Stress[i] = SingleBarStress(DX, DY, DZ, E, U, n, i);
+}
+
+#ifdef STAP_X86_KERNELS
+
+//	AVX2 kernels
+//	The dot products use four independent accumulators of four lanes. The axpy kernels are
+//	compiled without FMA so that the products are rounded as in the scalar kernels.
+
+__attribute__((target("avx2,fma")))
+static double AVX2Sum(__m256d s)
+{
+	__m128d h = _mm_add_pd(_mm256_castpd256_pd128(s), _mm256_extractf128_pd(s, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+}
+
+__attribute__((target("avx2,fma")))
+static double AVX2Dot(const double* a, const double* b, unsigned int n)
+{
+	__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+	__m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+
+	unsigned int k = 0;
+	for (; k + 16 <= n; k += 16)
+	{
+		s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + k), _mm256_loadu_pd(b + k), s0);
+		s1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + k + 4), _mm256_loadu_pd(b + k + 4), s1);
+		s2 = _mm256_fmadd_pd(_mm256_loadu_pd(a + k + 8), _mm256_loadu_pd(b + k + 8), s2);
+		s3 = _mm256_fmadd_pd(_mm256_loadu_pd(a + k + 12), _mm256_loadu_pd(b + k + 12), s3);
+	}
+	for (; k + 4 <= n; k += 4)
+		s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + k), _mm256_loadu_pd(b + k), s0);
+
+	double C = AVX2Sum(_mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+	for (; k < n; k++)
+		C += a[k] * b[k];
+
+	return C;
+}
+
+__attribute__((target("avx2,fma")))
+static double AVX2DotReverse(const double* a, const double* b, unsigned int n)
+{
+	__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+
+//	b[n-4-k:n-1-k] is loaded and its lanes are reversed to match a[k:k+3]
+	unsigned int k = 0;
+	for (; k + 8 <= n; k += 8)
+	{
+		__m256d b0 = _mm256_permute4x64_pd(_mm256_loadu_pd(b + n - 4 - k), 0x1B);
+		__m256d b1 = _mm256_permute4x64_pd(_mm256_loadu_pd(b + n - 8 - k), 0x1B);
+		s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + k), b0, s0);
+		s1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + k + 4), b1, s1);
+	}
+	for (; k + 4 <= n; k += 4)
+		s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + k), _mm256_permute4x64_pd(_mm256_loadu_pd(b + n - 4 - k), 0x1B), s0);
+
+	double C = AVX2Sum(_mm256_add_pd(s0, s1));
+	for (; k < n; k++)
+		C += a[k] * b[n-1-k];
+
+	return C;
+}
+
+__attribute__((target("avx2")))
+static void AVX2Axpy(double* y, double alpha, const double* x, unsigned int n)
+{
+	__m256d va = _mm256_set1_pd(alpha);
+
+	unsigned int k = 0;
+	for (; k + 4 <= n; k += 4)
+		_mm256_storeu_pd(y + k, _mm256_add_pd(_mm256_loadu_pd(y + k), _mm256_mul_pd(va, _mm256_loadu_pd(x + k))));
+
+	for (; k < n; k++)
+		y[k] += alpha * x[k];
+}
+
+__attribute__((target("avx2")))
+static void AVX2AxpyReverse(double* y, double alpha, const double* x, unsigned int n)
+{
+	__m256d va = _mm256_set1_pd(alpha);
+
+	unsigned int k = 0;
+	for (; k + 4 <= n; k += 4)
+	{
+		__m256d vx = _mm256_permute4x64_pd(_mm256_loadu_pd(x + n - 4 - k), 0x1B);
+		_mm256_storeu_pd(y + k, _mm256_add_pd(_mm256_loadu_pd(y + k), _mm256_mul_pd(va, vx)));
+	}
+
+	for (; k < n; k++)
+		y[k] += alpha * x[n-1-k];
+}
+
+//	Four bars are evaluated at once. The square root and the divisions are correctly rounded
+//	as in the scalar kernel, and no FMA is used
+__attribute__((target("avx2")))
+static void AVX2BarStiffness(const double* DX, const double* DY, const double* DZ, const double* EA,
+							 unsigned int n, double* Matrices)
+{
+	unsigned int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256d dx = _mm256_loadu_pd(DX + i), dy = _mm256_loadu_pd(DY + i), dz = _mm256_loadu_pd(DZ + i);
+
+		__m256d DX2[6] = {_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy), _mm256_mul_pd(dz, dz),
+						  _mm256_mul_pd(dx, dy), _mm256_mul_pd(dy, dz), _mm256_mul_pd(dx, dz)};
+
+		__m256d L2 = _mm256_add_pd(_mm256_add_pd(DX2[0], DX2[1]), DX2[2]);
+		__m256d k = _mm256_div_pd(_mm256_div_pd(_mm256_loadu_pd(EA + i), _mm256_sqrt_pd(L2)), L2);
+
+		alignas(32) double K[6][4];
+		for (unsigned int j = 0; j < 6; j++)
+			_mm256_store_pd(K[j], _mm256_mul_pd(k, DX2[j]));
+
+		for (unsigned int l = 0; l < 4; l++)
+		{
+			double Kl[6] = {K[0][l], K[1][l], K[2][l], K[3][l], K[4][l], K[5][l]};
+			StoreBarStiffness(Kl, Matrices + 21 * (size_t)(i + l));
+		}
+	}
+
+	ScalarBarStiffness(DX + i, DY + i, DZ + i, EA + i, n - i, Matrices + 21 * (size_t)i);
+}
+
+__attribute__((target("avx2")))
+static void AVX2BarStress(const double* DX, const double* DY, const double* DZ, const double* E,
+						  const double* U, unsigned int n, double* Stress)
+{
+	const __m256d Sign = _mm256_set1_pd(-0.0);
+
+	unsigned int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256d dx = _mm256_loadu_pd(DX + i), dy = _mm256_loadu_pd(DY + i), dz = _mm256_loadu_pd(DZ + i);
+		__m256d e = _mm256_loadu_pd(E + i);
+
+		__m256d L2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), _mm256_mul_pd(dz, dz));
+		__m256d S[3] = {_mm256_div_pd(_mm256_mul_pd(_mm256_xor_pd(dx, Sign), e), L2),
+						_mm256_div_pd(_mm256_mul_pd(_mm256_xor_pd(dy, Sign), e), L2),
+						_mm256_div_pd(_mm256_mul_pd(_mm256_xor_pd(dz, Sign), e), L2)};
+
+		__m256d stress = _mm256_setzero_pd();
+		for (unsigned int j = 0; j < 3; j++)
+			stress = _mm256_add_pd(stress, _mm256_mul_pd(S[j], _mm256_loadu_pd(U + j * n + i)));
+		for (unsigned int j = 0; j < 3; j++)
+			stress = _mm256_add_pd(stress, _mm256_mul_pd(_mm256_xor_pd(S[j], Sign), _mm256_loadu_pd(U + (j + 3) * n + i)));
+
+		_mm256_storeu_pd(Stress + i, stress);
+	}
+
+	for (; i < n; i++)
+		Stress[i] = SingleBarStress(DX, DY, DZ, E, U, n, i);
+}
+
+//	AVX-512 kernels
+//	The remainders are handled with masked loads, so that no scalar tail loop is needed
+
+__attribute__((target("avx512f")))
+static double AVX512Dot(const double* a, const double* b, unsigned int n)
+{
+	__m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+	__m512d s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+
+	unsigned int k = 0;
+	for (; k + 32 <= n; k += 32)
+	{
+		s0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + k), _mm512_loadu_pd(b + k), s0);
+		s1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + k + 8), _mm512_loadu_pd(b + k + 8), s1);
+		s2 = _mm512_fmadd_pd(_mm512_loadu_pd(a + k + 16), _mm512_loadu_pd(b + k + 16), s2);
+		s3 = _mm512_fmadd_pd(_mm512_loadu_pd(a + k + 24), _mm512_loadu_pd(b + k + 24), s3);
+	}
+	for (; k + 8 <= n; k += 8)
+		s0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + k), _mm512_loadu_pd(b + k), s0);
+
+	if (k < n)
+	{
+		__mmask8 m = (__mmask8)((1u << (n - k)) - 1);
+		s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, a + k), _mm512_maskz_loadu_pd(m, b + k), s1);
+	}
+
+	return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(s0, s1), _mm512_add_pd(s2, s3)));
+}
+
+__attribute__((target("avx512f")))
+static double AVX512DotReverse(const double* a, const double* b, unsigned int n)
+{
+	const __m512i Reverse = _mm512_set_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+	__m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+
+//	b[n-8-k:n-1-k] is loaded and its lanes are reversed to match a[k:k+7]
+	unsigned int k = 0;
+	for (; k + 16 <= n; k += 16)
+	{
+		__m512d b0 = _mm512_permutexvar_pd(Reverse, _mm512_loadu_pd(b + n - 8 - k));
+		__m512d b1 = _mm512_permutexvar_pd(Reverse, _mm512_loadu_pd(b + n - 16 - k));
+		s0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + k), b0, s0);
+		s1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + k + 8), b1, s1);
+	}
+	for (; k + 8 <= n; k += 8)
+		s0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + k), _mm512_permutexvar_pd(Reverse, _mm512_loadu_pd(b + n - 8 - k)), s0);
+
+	double C = _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+	for (; k < n; k++)
+		C += a[k] * b[n-1-k];
+
+	return C;
+}
+
+__attribute__((target("avx512f")))
+static void AVX512Axpy(double* y, double alpha, const double* x, unsigned int n)
+{
+	__m512d va = _mm512_set1_pd(alpha);
+
+	unsigned int k = 0;
+	for (; k + 8 <= n; k += 8)
+		_mm512_storeu_pd(y + k, _mm512_add_pd(_mm512_loadu_pd(y + k), _mm512_mul_pd(va, _mm512_loadu_pd(x + k))));
+
+	if (k < n)
+	{
+		__mmask8 m = (__mmask8)((1u << (n - k)) - 1);
+		__m512d vy = _mm512_maskz_loadu_pd(m, y + k);
+		_mm512_mask_storeu_pd(y + k, m, _mm512_add_pd(vy, _mm512_mul_pd(va, _mm512_maskz_loadu_pd(m, x + k))));
+	}
+}
+
+__attribute__((target("avx512f")))
+static void AVX512AxpyReverse(double* y, double alpha, const double* x, unsigned int n)
+{
+	const __m512i Reverse = _mm512_set_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+	__m512d va = _mm512_set1_pd(alpha);
+
+	unsigned int k = 0;
+	for (; k + 8 <= n; k += 8)
+	{
+		__m512d vx = _mm512_permutexvar_pd(Reverse, _mm512_loadu_pd(x + n - 8 - k));
+		_mm512_storeu_pd(y + k, _mm512_add_pd(_mm512_loadu_pd(y + k), _mm512_mul_pd(va, vx)));
+	}
+
+	for (; k < n; k++)
+		y[k] += alpha * x[n-1-k];
+}
+
+//	Eight bars are evaluated at once, the remainder with masked loads. The inactive lanes are
+//	set to a unit bar, and their results are not stored
+__attribute__((target("avx512f")))
+static void AVX512BarStiffness(const double* DX, const double* DY, const double* DZ, const double* EA,
+							   unsigned int n, double* Matrices)
+{
+	const __m512d One = _mm512_set1_pd(1.0);
+
+	for (unsigned int i = 0; i < n; i += 8)
+	{
+		unsigned int Lanes = n - i < 8 ? n - i : 8;
+		__mmask8 m = (__mmask8)((1u << Lanes) - 1);
+
+		__m512d dx = _mm512_mask_loadu_pd(One, m, DX + i), dy = _mm512_maskz_loadu_pd(m, DY + i);
+		__m512d dz = _mm512_maskz_loadu_pd(m, DZ + i);
+
+		__m512d DX2[6] = {_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy), _mm512_mul_pd(dz, dz),
+						  _mm512_mul_pd(dx, dy), _mm512_mul_pd(dy, dz), _mm512_mul_pd(dx, dz)};
+
+		__m512d L2 = _mm512_add_pd(_mm512_add_pd(DX2[0], DX2[1]), DX2[2]);
+		__m512d k = _mm512_div_pd(_mm512_div_pd(_mm512_mask_loadu_pd(One, m, EA + i), _mm512_sqrt_pd(L2)), L2);
+
+		alignas(64) double K[6][8];
+		for (unsigned int j = 0; j < 6; j++)
+			_mm512_store_pd(K[j], _mm512_mul_pd(k, DX2[j]));
+
+		for (unsigned int l = 0; l < Lanes; l++)
+		{
+			double Kl[6] = {K[0][l], K[1][l], K[2][l], K[3][l], K[4][l], K[5][l]};
+			StoreBarStiffness(Kl, Matrices + 21 * (size_t)(i + l));
+		}
+	}
+}
+
+__attribute__((target("avx512f")))
+static void AVX512BarStress(const double* DX, const double* DY, const double* DZ, const double* E,
+							const double* U, unsigned int n, double* Stress)
+{
+	const __m512d One = _mm512_set1_pd(1.0);
+	const __m512i Sign = _mm512_set1_epi64((long long)0x8000000000000000ULL);
+
+	for (unsigned int i = 0; i < n; i += 8)
+	{
+		__mmask8 m = (__mmask8)((1u << (n - i < 8 ? n - i : 8)) - 1);
+
+		__m512d dx = _mm512_mask_loadu_pd(One, m, DX + i), dy = _mm512_maskz_loadu_pd(m, DY + i);
+		__m512d dz = _mm512_maskz_loadu_pd(m, DZ + i), e = _mm512_maskz_loadu_pd(m, E + i);
+
+		__m512d L2 = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)), _mm512_mul_pd(dz, dz));
+
+		__m512d S[3];
+		S[0] = _mm512_div_pd(_mm512_mul_pd(_mm512_castsi512_pd(_mm512_xor_epi64(_mm512_castpd_si512(dx), Sign)), e), L2);
+		S[1] = _mm512_div_pd(_mm512_mul_pd(_mm512_castsi512_pd(_mm512_xor_epi64(_mm512_castpd_si512(dy), Sign)), e), L2);
+		S[2] = _mm512_div_pd(_mm512_mul_pd(_mm512_castsi512_pd(_mm512_xor_epi64(_mm512_castpd_si512(dz), Sign)), e), L2);
+
+		__m512d stress = _mm512_setzero_pd();
+		for (unsigned int j = 0; j < 3; j++)
+			stress = _mm512_add_pd(stress, _mm512_mul_pd(S[j], _mm512_maskz_loadu_pd(m, U + j * n + i)));
+		for (unsigned int j = 0; j < 3; j++)
+		{
+			__m512d NegativeS = _mm512_castsi512_pd(_mm512_xor_epi64(_mm512_castpd_si512(S[j]), Sign));
+			stress = _mm512_add_pd(stress, _mm512_mul_pd(NegativeS, _mm512_maskz_loadu_pd(m, U + (j + 3) * n + i)));
+		}
+
+		_mm512_mask_storeu_pd(Stress + i, m, stress);
+	}
+}
+
+#endif
+
+double (*CKernels::Dot_)(const double*, const double*, unsigned int) = ScalarDot;
+double (*CKernels::DotReverse_)(const double*, const double*, unsigned int) = ScalarDotReverse;
+void (*CKernels::Axpy_)(double*, double, const double*, unsigned int) = ScalarAxpy;
+void (*CKernels::AxpyReverse_)(double*, double, const double*, unsigned int) = ScalarAxpyReverse;
+void (*CKernels::BarStiffness_)(const double*, const double*, const double*, const double*, unsigned int, double*)
+	= ScalarBarStiffness;
+void (*CKernels::BarStress_)(const double*, const double*, const double*, const double*, const double*, unsigned int, double*)
+	= ScalarBarStress;
+
+//	The fastest supported kernels are selected before main is entered
+SIMDLevels CKernels::Level_ = CKernels::SetLevel(CKernels::GetSupportedLevel());
+
+//	Return the fastest instruction set supported by the processor and the compiler
+SIMDLevels CKernels::GetSupportedLevel()
+{
+#ifdef STAP_X86_KERNELS
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512f"))
+		return AVX512Kernels;
+
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return AVX2Kernels;
+#endif
+
+	return ScalarKernels;
+}
+
+//	Select the kernels of the instruction set Level, or of the fastest supported one
+SIMDLevels CKernels::SetLevel(SIMDLevels Level)
+{
+	SIMDLevels Supported = GetSupportedLevel();
+	if (Level > Supported)
+		Level = Supported;
+
+	Dot_ = ScalarDot;
+	DotReverse_ = ScalarDotReverse;
+	Axpy_ = ScalarAxpy;
+	AxpyReverse_ = ScalarAxpyReverse;
+	BarStiffness_ = ScalarBarStiffness;
+	BarStress_ = ScalarBarStress;
+
+#ifdef STAP_X86_KERNELS
+	if (Level == AVX2Kernels)
+	{
+		Dot_ = AVX2Dot;
+		DotReverse_ = AVX2DotReverse;
+		Axpy_ = AVX2Axpy;
+		AxpyReverse_ = AVX2AxpyReverse;
+		BarStiffness_ = AVX2BarStiffness;
+		BarStress_ = AVX2BarStress;
+	}
+	else if (Level == AVX512Kernels)
+	{
+		Dot_ = AVX512Dot;
+		DotReverse_ = AVX512DotReverse;
+		Axpy_ = AVX512Axpy;
+		AxpyReverse_ = AVX512AxpyReverse;
+		BarStiffness_ = AVX512BarStiffness;
+		BarStress_ = AVX512BarStress;
+	}
+#endif
+
+	Level_ = Level;
+	return Level;
+}
+
+//	Return the name of an instruction set
+const char* CKernels::GetLevelName(SIMDLevels Level)
+{
+	switch (Level)
+	{
+		case AVX2Kernels:
+			return "avx2";
+		case AVX512Kernels:
+			return "avx512";
+		default:
+			return "scalar";
+	}
+}
@@ -31,7 +31,7 @@ void CLoadCaseData :: Allocate(unsigned int num)
 }; 
 
 //	Read load case data from stream Input
-bool CLoadCaseData :: Read(ifstream& Input)
+bool CLoadCaseData :: Read(CTokenizer& Input)
 {
 //	Load case number (LL) and number of concentrated loads in this load case(NL)
 	
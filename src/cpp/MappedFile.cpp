@@ -0,0 +1,159 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#include "MappedFile.h"
+
+#include <vector>
+#include <algorithm>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define STAP_MAPPED_FILES
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+//	Desconstructor
+CMappedFile::~CMappedFile()
+{
+	delete [] Buffer_;
+
+#ifdef STAP_MAPPED_FILES
+	if (data_ && data_ != Buffer_)
+		munmap(data_, size_);
+
+	if (File_ >= 0)
+		close(File_);
+#endif
+}
+
+//	Create a zero-filled scratch file of Size bytes in Directory and map it into memory
+bool CMappedFile::Create(const string& Directory, size_t Size)
+{
+#ifdef STAP_MAPPED_FILES
+	if (!Size)
+		Size = 1;
+
+	string Template = Directory + "/stap++.XXXXXX";
+	vector<char> Name(Template.begin(), Template.end());
+	Name.push_back('\0');
+
+	File_ = mkstemp(Name.data());
+	if (File_ < 0)
+		return false;
+
+	unlink(Name.data());
+
+//	The file is extended without writing, so its blocks are only allocated when they are modified
+	if (ftruncate(File_, (off_t)Size) != 0)
+		return false;
+
+	void* Address = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED, File_, 0);
+	if (Address == MAP_FAILED)
+		return false;
+
+//	Pages are mapped one by one, instead of with their neighbours, so that scattered accesses
+//	only keep the touched pages in memory. Sequential accesses are prefetched explicitly.
+	madvise(Address, Size, MADV_RANDOM);
+
+	data_ = (char*)Address;
+	size_ = Size;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+//	Map the existing file FileName into memory for reading
+bool CMappedFile::Open(const string& FileName)
+{
+#ifdef STAP_MAPPED_FILES
+	File_ = open(FileName.c_str(), O_RDONLY);
+	if (File_ < 0)
+		return false;
+
+	off_t Size = lseek(File_, 0, SEEK_END);
+	if (Size > 0)
+	{
+		void* Address = mmap(nullptr, (size_t)Size, PROT_READ, MAP_PRIVATE, File_, 0);
+
+		if (Address != MAP_FAILED)
+		{
+//			The file is read once from the beginning to the end
+			madvise(Address, (size_t)Size, MADV_SEQUENTIAL);
+
+			data_ = (char*)Address;
+			size_ = (size_t)Size;
+
+			return true;
+		}
+	}
+#endif
+
+//	Read the whole file when it cannot be mapped
+	ifstream Input(FileName, ios::binary | ios::ate);
+	if (!Input)
+		return false;
+
+	size_ = (size_t)Input.tellg();
+	Buffer_ = new char [size_ ? size_ : 1];
+
+	Input.seekg(0);
+	Input.read(Buffer_, size_);
+
+	data_ = Buffer_;
+
+	return (bool)Input;
+}
+
+//	Return the size of the memory pages
+size_t CMappedFile::PageSize()
+{
+#ifdef STAP_MAPPED_FILES
+	return (size_t)sysconf(_SC_PAGESIZE);
+#else
+	return 4096;
+#endif
+}
+
+//	Start reading the bytes [Offset, Offset+Length) asynchronously
+void CMappedFile::Prefetch(size_t Offset, size_t Length)
+{
+#ifdef STAP_MAPPED_FILES
+	size_t Page = PageSize();
+
+	size_t First = Offset / Page * Page;
+	size_t Last = min(Offset + Length, size_);
+
+	if (data_ && First < Last)
+		madvise(data_ + First, Last - First, MADV_WILLNEED);
+#endif
+}
+
+//	Remove the pages contained in [Offset, Offset+Length) from memory
+//	Only whole pages are released, so that the neighbouring data stays in memory
+void CMappedFile::Release(size_t Offset, size_t Length)
+{
+#ifdef STAP_MAPPED_FILES
+	size_t Page = PageSize();
+
+	size_t First = (Offset + Page - 1) / Page * Page;
+	size_t Last = min(Offset + Length, size_);
+
+	if (Last < size_)
+		Last = Last / Page * Page;
+
+	if (data_ && First < Last)
+		madvise(data_ + First, Last - First, MADV_DONTNEED);
+#endif
+}
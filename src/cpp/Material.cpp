@@ -17,7 +17,7 @@
 using namespace std;
 
 //	Read material data from stream Input
-bool CBarMaterial::Read(ifstream& Input)
+bool CBarMaterial::Read(CTokenizer& Input)
 {
 	Input >> nset;	// Number of property set
 
@@ -31,3 +31,17 @@ void CBarMaterial::Write(COutputter& output)
 {
 	output << setw(16) << E << setw(16) << Area << endl;
 }
+
+//	Copy the material properties E and Area to Properties
+void CBarMaterial::GetProperties(double* Properties)
+{
+	Properties[0] = E;
+	Properties[1] = Area;
+}
+
+//	Set the material properties E and Area from Properties
+void CBarMaterial::SetProperties(const double* Properties)
+{
+	E = Properties[0];
+	Area = Properties[1];
+}
@@ -25,7 +25,7 @@ CNode::CNode(double X, double Y, double Z)
 };
 
 //	Read element data from stream Input
-bool CNode::Read(ifstream& Input)
+bool CNode::Read(CTokenizer& Input)
 {
 	Input >> NodeNumber;	// node number
 	Input >> bcode[0] >> bcode[1] >> bcode[2]
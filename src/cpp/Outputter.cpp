@@ -9,10 +9,12 @@
 /*****************************************************************************/
 
 #include <ctime>
+#include <cstdlib>
 
 #include "Domain.h"
 #include "Outputter.h"
 #include "SkylineMatrix.h"
+#include "Profiler.h"
 
 using namespace std;
 
@@ -33,8 +35,10 @@ void COutputter::PrintTime(const struct tm* ptm, COutputter &output)
 
 COutputter* COutputter::_instance = nullptr;
 
+bool COutputter::Console_ = true;
+
 //	Constructor
-COutputter::COutputter(string FileName)
+COutputter::COutputter(string FileName) : Done_(false), Results_(nullptr), TextResults_(true), LoadCase_(0)
 {
 	OutputFile.open(FileName);
 
@@ -43,17 +47,169 @@ COutputter::COutputter(string FileName)
 		cerr << "*** Error *** File " << FileName << " does not exist !" << endl;
 		exit(3);
 	}
+
+	Writer_ = thread(&COutputter::Write, this);
 }
 
 //	Return the single instance of the class
 COutputter* COutputter::GetInstance(string FileName)
 {
 	if (!_instance)
+	{
 		_instance = new COutputter(FileName);
+
+//		The output is completed when the program exits, also from an error
+		static bool Registered = false;
+		if (!Registered)
+		{
+			atexit(Finish);
+			Registered = true;
+		}
+	}
     
 	return _instance;
 }
 
+//	Delete the single instance of the class, after its output is written
+void COutputter::DeleteInstance()
+{
+	if (!_instance)
+		return;
+
+	Finish();
+
+	delete _instance;
+	_instance = nullptr;
+}
+
+//	Write the queued blocks until Done_ is set
+//	A block stays at the front of the queue while it is written, so that Flush waits for it.
+//	References to it are not invalidated by the blocks queued meanwhile.
+void COutputter::Write()
+{
+	unique_lock<mutex> Lock(Mutex_);
+
+	while (true)
+	{
+		Signal_.wait(Lock, [this] { return !Blocks_.empty() || Done_; });
+
+		if (Blocks_.empty())
+			return;
+
+		const string& Block = Blocks_.front();
+
+		Lock.unlock();
+
+		if (Console_)
+			cout.write(Block.data(), Block.size());
+
+		OutputFile.write(Block.data(), Block.size());
+
+		Lock.lock();
+
+		Blocks_.pop_front();
+		Signal_.notify_all();
+	}
+}
+
+//	Pass the buffer to the writer thread, waiting if too many blocks are queued
+void COutputter::Submit()
+{
+	string Block = Buffer_.str();
+	Buffer_.str("");
+
+	unique_lock<mutex> Lock(Mutex_);
+
+	Signal_.wait(Lock, [this] { return Blocks_.size() < MaximumBlocks; });
+
+	Blocks_.push_back(move(Block));
+	Signal_.notify_all();
+}
+
+//	Write all output passed so far to the output file and the console
+void COutputter::Flush()
+{
+	CProfileScope Scope("COutputter::Flush");
+
+	if (Buffer_.tellp() > 0)
+		Submit();
+
+	unique_lock<mutex> Lock(Mutex_);
+
+	Signal_.wait(Lock, [this] { return Blocks_.empty(); });
+
+	OutputFile.flush();
+
+	if (Console_)
+		cout.flush();
+}
+
+//	Write the displacements and stresses of all load cases to the binary results file FileName
+bool COutputter::OpenResults(const string& FileName, bool Text)
+{
+	CDomain* FEMData = CDomain::GetInstance();
+
+//	Element type, number of elements and number of stress columns of each element group
+	vector<unsigned int> Groups;
+
+	for (unsigned int EleGrp = 0; EleGrp < FEMData->GetNUMEG(); EleGrp++)
+	{
+		CElementGroup& Group = FEMData->GetEleGrpList()[EleGrp];
+		ElementTypes ElementType = Group.GetElementType();
+
+		Groups.push_back(ElementType);
+		Groups.push_back(Group.GetNUME());
+		Groups.push_back(Group.GetNCOL());	// e.g. force and stress of bars
+	}
+
+	Results_ = new CResultsFile;
+
+	if (!Results_->Create(FileName, FEMData->GetTitle(), FEMData->GetNUMNP(), CNode::NDF, FEMData->GetNLCASE(), Groups))
+	{
+		delete Results_;
+		Results_ = nullptr;
+
+		return false;
+	}
+
+	TextResults_ = Text;
+	LoadCase_ = 0;
+
+	return true;
+}
+
+//	Close the binary results file
+bool COutputter::CloseResults()
+{
+	if (!Results_)
+		return true;
+
+	bool Success = Results_->Close();
+
+	delete Results_;
+	Results_ = nullptr;
+
+	return Success;
+}
+
+//	Write the remaining output and stop the writer thread
+void COutputter::Finish()
+{
+	if (!_instance)
+		return;
+
+	_instance->CloseResults();
+	_instance->Flush();
+
+	{
+		lock_guard<mutex> Lock(_instance->Mutex_);
+		_instance->Done_ = true;
+	}
+
+	_instance->Signal_.notify_all();
+	_instance->Writer_.join();
+}
+
 //	Print program logo
 void COutputter::OutputHeading()
 {
@@ -241,9 +397,30 @@ void COutputter::OutputLoadInfo()
 //	Print nodal displacement
 void COutputter::OutputNodalDisplacement()
 {
+	CProfileScope Scope("COutputter::OutputNodalDisplacement");
+
 	CDomain* FEMData = CDomain::GetInstance();
 	CNode* NodeList = FEMData->GetNodeList();
 	double* Displacement = FEMData->GetDisplacement();
+	unsigned int NUMNP = FEMData->GetNUMNP();
+
+//	The displacements of the constrained degrees of freedom are zero in the results file
+	if (Results_)
+	{
+		vector<double> Displacements((size_t)NUMNP * CNode::NDF);
+
+		for (unsigned int np = 0; np < NUMNP; np++)
+			for (unsigned int dof = 0; dof < CNode::NDF; dof++)
+			{
+				unsigned int Equation = NodeList[np].bcode[dof];
+				Displacements[(size_t)np * CNode::NDF + dof] = Equation ? Displacement[Equation - 1] : 0.0;
+			}
+
+		Results_->WriteDisplacements(++LoadCase_, Displacements.data());
+	}
+
+	if (!TextResults_)
+		return;
 
 	*this << setiosflags(ios::scientific);
 
@@ -251,7 +428,7 @@ void COutputter::OutputNodalDisplacement()
 		  << endl;
 	*this << "  NODE           X-DISPLACEMENT    Y-DISPLACEMENT    Z-DISPLACEMENT" << endl;
 
-	for (unsigned int np = 0; np < FEMData->GetNUMNP(); np++)
+	for (unsigned int np = 0; np < NUMNP; np++)
 		NodeList[np].WriteNodalDisplacement(*this, Displacement);
 
 	*this << endl;
@@ -260,43 +437,46 @@ void COutputter::OutputNodalDisplacement()
 //	Calculate stresses
 void COutputter::OutputElementStress()
 {
-	CDomain* FEMData = CDomain::GetInstance();
+	CProfileScope Scope("COutputter::OutputElementStress");
 
-	double* Displacement = FEMData->GetDisplacement();
+	CDomain* FEMData = CDomain::GetInstance();
 
 	unsigned int NUMEG = FEMData->GetNUMEG();
 
 	for (unsigned int EleGrpIndex = 0; EleGrpIndex < NUMEG; EleGrpIndex++)
 	{
-		*this << " S T R E S S  C A L C U L A T I O N S  F O R  E L E M E N T  G R O U P" << setw(5)
-			  << EleGrpIndex + 1 << endl
-			  << endl;
-
 		CElementGroup& EleGrp = FEMData->GetEleGrpList()[EleGrpIndex];
 		unsigned int NUME = EleGrp.GetNUME();
 		ElementTypes ElementType = EleGrp.GetElementType();
 
+		if (TextResults_)
+			*this << " S T R E S S  C A L C U L A T I O N S  F O R  E L E M E N T  G R O U P" << setw(5)
+				  << EleGrpIndex + 1 << endl
+				  << endl;
+
 		switch (ElementType)
 		{
 			case ElementTypes::Bar: // Bar element
-				*this << "  ELEMENT             FORCE            STRESS" << endl
-					<< "  NUMBER" << endl;
+			{
+				if (TextResults_)
+					*this << "  ELEMENT             FORCE            STRESS" << endl
+						<< "  NUMBER" << endl;
 
-				double stress;
+				const double* Stresses = EleGrp.GetStresses();	// Force and stress
 
-				for (unsigned int Ele = 0; Ele < NUME; Ele++)
-				{
-					CElement& Element = EleGrp[Ele];
-					Element.ElementStress(&stress, Displacement);
+				if (TextResults_)
+					for (unsigned int Ele = 0; Ele < NUME; Ele++)
+						*this << setw(5) << Ele + 1 << setw(22) << Stresses[2 * (size_t)Ele] << setw(18)
+							<< Stresses[2 * (size_t)Ele + 1] << endl;
 
-					CBarMaterial& material = *dynamic_cast<CBarMaterial*>(Element.GetElementMaterial());
-					*this << setw(5) << Ele + 1 << setw(22) << stress * material.Area << setw(18)
-						<< stress << endl;
-				}
+				if (Results_)
+					Results_->WriteStresses(Stresses, 2 * (size_t)NUME);
 
-				*this << endl;
+				if (TextResults_)
+					*this << endl;
 
 				break;
+			}
 
 			default: // Invalid element type
 				cerr << "*** Error *** Elment type " << ElementType
@@ -313,6 +493,28 @@ void COutputter::OutputTotalSystemData()
 	*this << "	TOTAL SYSTEM DATA" << endl
 		  << endl;
 
+	if (FEMData->GetSolverType() == SparsePCG)
+	{
+		*this << "     NUMBER OF EQUATIONS . . . . . . . . . . . . . .(NEQ) = " << FEMData->GetNEQ()
+			  << endl;
+
+//		The sparsity pattern is not calculated by a data check
+		if (FEMData->GetSparseStiffnessMatrix())
+			*this << "     NUMBER OF NONZERO MATRIX ELEMENTS . . . . . . .(NNZ) = " << FEMData->GetSparseStiffnessMatrix()->size()
+				  << endl;
+		else
+			*this << "     MAXIMUM NUMBER OF NONZERO MATRIX ELEMENTS . . . . . = " << FEMData->GetSparseEntries()
+				  << endl;
+
+		*this << endl;
+
+		OutputMemoryEstimate();
+
+		*this << endl;
+
+		return;
+	}
+
 	*this << "     NUMBER OF EQUATIONS . . . . . . . . . . . . . .(NEQ) = " << FEMData->GetNEQ()
 		  << endl
 		  << "     NUMBER OF MATRIX ELEMENTS . . . . . . . . . . .(NWK) = " << FEMData->GetStiffnessMatrix()->size()
@@ -320,8 +522,47 @@ void COutputter::OutputTotalSystemData()
 		  << "     MAXIMUM HALF BANDWIDTH  . . . . . . . . . . . .(MK ) = " << FEMData->GetStiffnessMatrix()->GetMaximumHalfBandwidth()
 		  << endl
 		  << "     MEAN HALF BANDWIDTH . . . . . . . . . . . . . .(MM ) = " << FEMData->GetStiffnessMatrix()->size() / FEMData->GetNEQ() << endl
-		  << endl
 		  << endl;
+
+//	Profile of the equation numbers in input order, when the equations are renumbered
+	if (FEMData->GetReorder())
+		*this << "     NUMBER OF MATRIX ELEMENTS IN INPUT ORDER  . . .(NWK) = " << FEMData->GetNWKInput()
+			  << endl
+			  << "     MAXIMUM HALF BANDWIDTH IN INPUT ORDER . . . . .(MK ) = " << FEMData->GetMKInput()
+			  << endl
+			  << endl;
+
+//	Memory budget of the out of core solver
+	if (FEMData->IsOutOfCore())
+		*this << "     OUT OF CORE SKYLINE, MEMORY BUDGET IN MB  . . . . . = " << FEMData->GetMemoryBudget() / 1048576
+			  << endl
+			  << endl;
+
+	OutputMemoryEstimate();
+
+	*this << endl;
+}
+
+//	Print the memory of the solution
+void COutputter::OutputMemoryEstimate()
+{
+	CDomain* FEMData = CDomain::GetInstance();
+	const CMemoryEstimate& Memory = FEMData->GetMemoryEstimate();
+
+	*this << "     MEMORY OF NODES IN BYTES  . . . . . . . . . . . . . = " << Memory.Nodes << endl
+		  << "     MEMORY OF ELEMENTS IN BYTES . . . . . . . . . . . . = " << Memory.Elements << endl
+		  << "     MEMORY OF LOADS IN BYTES  . . . . . . . . . . . . . = " << Memory.Loads << endl
+		  << "     MEMORY OF FORCE VECTORS IN BYTES  . . . . . . . . . = " << Memory.Vectors << endl
+		  << "     MEMORY OF STIFFNESS MATRIX IN BYTES . . . . . . . . = " << Memory.Matrix << endl
+		  << "     TOTAL MEMORY OF THE SOLUTION IN BYTES . . . . . . . = " << Memory.Total() << endl;
+
+	if (Memory.ScratchFile)
+		*this << "     SCRATCH FILE OF THE SKYLINE IN BYTES  . . . . . . . = " << Memory.ScratchFile << endl;
+
+	if (FEMData->GetMemoryLimit())
+		*this << "     MEMORY LIMIT IN BYTES . . . . . . . . . . . . . . . = " << FEMData->GetMemoryLimit() << endl;
+
+	*this << endl;
 }
 
 #ifdef _DEBUG_
@@ -360,7 +601,7 @@ void COutputter::PrintDiagonalAddress()
 
 	unsigned int NEQ = FEMData->GetNEQ();
 	CSkylineMatrix<double> *StiffnessMatrix = FEMData->GetStiffnessMatrix();
-	unsigned int* DiagonalAddress = StiffnessMatrix->GetDiagonalAddress();
+	size_t* DiagonalAddress = StiffnessMatrix->GetDiagonalAddress();
 
 	for (unsigned int col = 0; col <= NEQ; col++)
 	{
@@ -385,11 +626,11 @@ void COutputter::PrintStiffnessMatrix()
 
 	unsigned int NEQ = FEMData->GetNEQ();
 	CSkylineMatrix<double> *StiffnessMatrix = FEMData->GetStiffnessMatrix();
-	unsigned int* DiagonalAddress = StiffnessMatrix->GetDiagonalAddress();
+	size_t* DiagonalAddress = StiffnessMatrix->GetDiagonalAddress();
 
 	*this << setiosflags(ios::scientific) << setprecision(5);
 
-	for (unsigned int i = 0; i < DiagonalAddress[NEQ] - DiagonalAddress[0]; i++)
+	for (size_t i = 0; i < DiagonalAddress[NEQ] - DiagonalAddress[0]; i++)
 	{
 		*this << setw(14) << (*StiffnessMatrix)(i);
 
@@ -410,7 +651,7 @@ void COutputter::PrintStiffnessMatrix()
 		{
 			int J_new = (J > I) ? J : I;
 			int I_new = (J > I) ? I : J;
-			int H = DiagonalAddress[J_new] - DiagonalAddress[J_new - 1];
+			int H = (int)(DiagonalAddress[J_new] - DiagonalAddress[J_new - 1]);
 			if (J_new - I_new - H >= 0)
 			{
 				*this << setw(14) << 0.0;
@@ -0,0 +1,22 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#include "Parallel.h"
+
+unsigned int CParallel::NumberOfThreads_ = 1;
+
+//	Set the number of threads (0 : use all hardware threads)
+void CParallel::SetNumberOfThreads(unsigned int N)
+{
+	if (!N)
+		N = thread::hardware_concurrency();
+
+	NumberOfThreads_ = N ? N : 1;
+}
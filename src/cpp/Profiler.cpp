@@ -0,0 +1,240 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#include "Profiler.h"
+
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define STAP_RESOURCE_USAGE
+#include <sys/resource.h>
+#endif
+
+#if defined(__linux__)
+#define STAP_PERF_COUNTERS
+#include <cstring>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
+#endif
+
+vector<CProfiler::CPhase> CProfiler::Phases_;
+
+mutex CProfiler::Mutex_;
+
+bool CProfiler::Enabled_ = false;
+
+//	Start of the program, to which the wall clock times of the phases are relative
+static const chrono::steady_clock::time_point Origin = chrono::steady_clock::now();
+
+//	Number of phases in progress on the calling thread
+static thread_local unsigned int Depth = 0;
+
+#ifdef STAP_PERF_COUNTERS
+//	Group of the cycles and instructions counters of a thread, opened at its first use
+struct CThreadCounters
+{
+	int Cycles = -1;
+	int Instructions = -1;
+	bool Opened = false;
+
+	~CThreadCounters()
+	{
+		if (Instructions >= 0)
+			close(Instructions);
+
+		if (Cycles >= 0)
+			close(Cycles);
+	}
+
+//	Open a counter of the calling thread in user space, in the group of Leader (-1 : a new group)
+	static int Open(unsigned long long Config, int Leader)
+	{
+		perf_event_attr Attributes;
+		memset(&Attributes, 0, sizeof(Attributes));
+
+		Attributes.size = sizeof(Attributes);
+		Attributes.type = PERF_TYPE_HARDWARE;
+		Attributes.config = Config;
+		Attributes.read_format = PERF_FORMAT_GROUP;
+		Attributes.exclude_kernel = 1;
+		Attributes.exclude_hv = 1;
+
+		return (int)syscall(SYS_perf_event_open, &Attributes, 0, -1, Leader, 0);
+	}
+
+	bool Read(long long Values[2])
+	{
+		if (!Opened)
+		{
+			Opened = true;
+
+			Cycles = Open(PERF_COUNT_HW_CPU_CYCLES, -1);
+			if (Cycles >= 0)
+				Instructions = Open(PERF_COUNT_HW_INSTRUCTIONS, Cycles);
+
+			if (Instructions < 0 && Cycles >= 0)
+			{
+				close(Cycles);
+				Cycles = -1;
+			}
+		}
+
+		if (Cycles < 0)
+			return false;
+
+//		Number of counters, followed by their values
+		uint64_t Data[3];
+		if (read(Cycles, Data, sizeof(Data)) != (ssize_t)sizeof(Data) || Data[0] != 2)
+			return false;
+
+		Values[0] = (long long)Data[1];
+		Values[1] = (long long)Data[2];
+
+		return true;
+	}
+};
+
+static thread_local CThreadCounters ThreadCounters;
+#endif
+
+//	Return the wall clock time in seconds since the start of the program
+double CProfiler::WallTime()
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - Origin).count();
+}
+
+//	Return the CPU time of the process (all threads) in seconds
+double CProfiler::CPUTime()
+{
+#ifdef STAP_RESOURCE_USAGE
+	timespec Time;
+	if (!clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &Time))
+		return Time.tv_sec + Time.tv_nsec * 1.0E-9;
+#endif
+
+	return (double)clock() / CLOCKS_PER_SEC;
+}
+
+//	Return the high-water mark of the resident memory in kilobytes
+long CProfiler::MaxRSS()
+{
+#ifdef STAP_RESOURCE_USAGE
+	rusage Usage;
+	if (!getrusage(RUSAGE_SELF, &Usage))
+#ifdef __APPLE__
+		return Usage.ru_maxrss / 1024;	// In bytes on macOS
+#else
+		return Usage.ru_maxrss;
+#endif
+#endif
+
+	return -1;
+}
+
+//	Read the cycles and instructions of the calling thread
+bool CProfiler::ReadCounters(long long Values[2])
+{
+#ifdef STAP_PERF_COUNTERS
+	if (Enabled_)
+		return ThreadCounters.Read(Values);
+#endif
+
+	return false;
+}
+
+//	Record a completed phase
+void CProfiler::Record(const CPhase& Phase)
+{
+	lock_guard<mutex> Lock(Mutex_);
+	Phases_.push_back(Phase);
+}
+
+//	Write the phases as complete events ("ph" : "X") of the Chrome trace event format, with the
+//	times in microseconds and the CPU time, memory and counters of each phase as its arguments
+bool CProfiler::WriteTrace(const string& FileName)
+{
+	ofstream Output(FileName);
+	if (!Output)
+		return false;
+
+	lock_guard<mutex> Lock(Mutex_);
+
+	Output << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+
+	Output << fixed << setprecision(3);
+
+	for (size_t i = 0; i < Phases_.size(); i++)
+	{
+		const CPhase& Phase = Phases_[i];
+
+		Output << (i ? ",\n" : "\n") << "{\"name\": \"" << Phase.Name << "\", \"cat\": \"stap++\", \"ph\": \"X\", "
+			   << "\"pid\": 1, \"tid\": " << Phase.Thread << ", \"ts\": " << Phase.Start * 1.0E6
+			   << ", \"dur\": " << Phase.Wall * 1.0E6 << ", \"args\": {\"depth\": " << Phase.Depth
+			   << ", \"cpu_ms\": " << Phase.CPU * 1.0E3;
+
+		if (Phase.MaxRSS >= 0)
+			Output << ", \"max_rss_kb\": " << Phase.MaxRSS;
+
+		if (Phase.Cycles >= 0)
+			Output << ", \"cycles\": " << Phase.Cycles << ", \"instructions\": " << Phase.Instructions;
+
+		Output << "}}";
+	}
+
+	Output << "\n]}\n";
+
+	return (bool)Output;
+}
+
+//	Begin the phase Name on the thread Thread
+CProfileScope::CProfileScope(const char* Name, unsigned int Thread)
+{
+	Active_ = CProfiler::IsEnabled();
+	if (!Active_)
+		return;
+
+	Phase_.Name = Name;
+	Phase_.Thread = Thread;
+	Phase_.Depth = Depth++;
+	Phase_.MaxRSS = -1;
+	Phase_.Cycles = Phase_.Instructions = -1;
+
+	Counted_ = CProfiler::ReadCounters(Counters_);
+
+	Phase_.CPU = CProfiler::CPUTime();
+	Phase_.Start = CProfiler::WallTime();
+}
+
+//	End the phase and record it
+CProfileScope::~CProfileScope()
+{
+	if (!Active_)
+		return;
+
+	Phase_.Wall = CProfiler::WallTime() - Phase_.Start;
+	Phase_.CPU = CProfiler::CPUTime() - Phase_.CPU;
+	Phase_.MaxRSS = CProfiler::MaxRSS();
+
+	long long Counters[2];
+	if (Counted_ && CProfiler::ReadCounters(Counters))
+	{
+		Phase_.Cycles = Counters[0] - Counters_[0];
+		Phase_.Instructions = Counters[1] - Counters_[1];
+	}
+
+	Depth--;
+
+	CProfiler::Record(Phase_);
+}
@@ -0,0 +1,143 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#include "ResultsFile.h"
+
+#include <cstring>
+#include <algorithm>
+
+//	Size of the header in bytes : magic, version, byte order, title, NUMNP, NDF, NUMEG, NLCASE
+static const size_t HeaderSize = 8 + 2 * 4 + 256 + 4 * 4;
+
+//	Create the results file FileName and write its header
+bool CResultsFile::Create(const string& FileName, const string& Title, unsigned int NUMNP, unsigned int NDF,
+						  unsigned int NLCASE, const vector<unsigned int>& Groups)
+{
+	Output_.open(FileName, ios::binary);
+	if (!Output_)
+		return false;
+
+	Title_ = Title;
+	NUMNP_ = NUMNP;
+	NDF_ = NDF;
+	NUMEG_ = (unsigned int)(Groups.size() / 3);
+	NLCASE_ = NLCASE;
+	Groups_ = Groups;
+
+	char Heading[256] = {0};
+	memcpy(Heading, Title.c_str(), min(Title.size(), (size_t)255));
+
+	Output_.write(Magic(), 8);
+
+	unsigned int Header[] = {Version, ByteOrder};
+	Write(Header, 2);
+
+	Write(Heading, 256);
+
+	unsigned int Sizes[] = {NUMNP_, NDF_, NUMEG_, NLCASE_};
+	Write(Sizes, 4);
+
+	Write(Groups_.data(), Groups_.size());
+
+	return (bool)Output_;
+}
+
+//	Start load case LoadCase with its nodal displacements
+void CResultsFile::WriteDisplacements(unsigned int LoadCase, const double* Displacements)
+{
+	Write(&LoadCase, 1);
+	Write(Displacements, (size_t)NUMNP_ * NDF_);
+}
+
+//	Write the stresses of the next element group
+void CResultsFile::WriteStresses(const double* Stresses, size_t Count)
+{
+	Write(Stresses, Count);
+}
+
+//	Close the file being written
+bool CResultsFile::Close()
+{
+	Output_.close();
+	return !Output_.fail();
+}
+
+//	Calculate the offsets of the load cases
+void CResultsFile::CalculateOffsets()
+{
+	FirstLoadCase_ = HeaderSize + (Groups_.size() * sizeof(unsigned int) + 7) / 8 * 8;
+
+	LoadCaseSize_ = 8 + (size_t)NUMNP_ * NDF_ * sizeof(double);
+	for (unsigned int EleGrp = 0; EleGrp < NUMEG_; EleGrp++)
+		LoadCaseSize_ += (size_t)GetNUME(EleGrp) * GetNCOL(EleGrp) * sizeof(double);
+}
+
+//	Open the results file FileName for reading
+bool CResultsFile::Open(const string& FileName)
+{
+	if (!File_.Open(FileName) || File_.size() < HeaderSize)
+		return false;
+
+	const char* Data = File_.data();
+
+	unsigned int Header[6];
+	memcpy(Header, Data + 8, 2 * sizeof(unsigned int));
+	memcpy(Header + 2, Data + 16 + 256, 4 * sizeof(unsigned int));
+
+	if (memcmp(Data, Magic(), 8) || Header[0] != Version || Header[1] != ByteOrder)
+		return false;
+
+	Title_ = string(Data + 16, strnlen(Data + 16, 256));
+	NUMNP_ = Header[2];
+	NDF_ = Header[3];
+	NUMEG_ = Header[4];
+	NLCASE_ = Header[5];
+
+	if ((File_.size() - HeaderSize) / (3 * sizeof(unsigned int)) < NUMEG_)
+		return false;
+
+	Groups_.resize(3 * (size_t)NUMEG_);
+	memcpy(Groups_.data(), Data + HeaderSize, Groups_.size() * sizeof(unsigned int));
+
+	CalculateOffsets();
+
+//	A results file of an interrupted run holds the load cases completed before
+	NumberOfLoadCases_ = 0;
+	if (File_.size() >= FirstLoadCase_)
+		NumberOfLoadCases_ = (unsigned int)min<size_t>((File_.size() - FirstLoadCase_) / LoadCaseSize_, NLCASE_);
+
+	return true;
+}
+
+//	Return the load case number of the lcase-th load case in the file
+unsigned int CResultsFile::GetLoadCase(unsigned int lcase)
+{
+	unsigned int LoadCase;
+	memcpy(&LoadCase, File_.data() + FirstLoadCase_ + lcase * LoadCaseSize_, sizeof(unsigned int));
+
+	return LoadCase;
+}
+
+//	Return the nodal displacements of the lcase-th load case in the file
+const double* CResultsFile::GetDisplacements(unsigned int lcase)
+{
+	return (const double*)(File_.data() + FirstLoadCase_ + lcase * LoadCaseSize_ + 8);
+}
+
+//	Return the stresses of element group EleGrp of the lcase-th load case in the file
+const double* CResultsFile::GetStresses(unsigned int lcase, unsigned int EleGrp)
+{
+	size_t Offset = FirstLoadCase_ + lcase * LoadCaseSize_ + 8 + (size_t)NUMNP_ * NDF_ * sizeof(double);
+
+	for (unsigned int i = 0; i < EleGrp; i++)
+		Offset += (size_t)GetNUME(i) * GetNCOL(i) * sizeof(double);
+
+	return (const double*)(File_.data() + Offset);
+}
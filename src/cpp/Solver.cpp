@@ -9,7 +9,14 @@
 /*****************************************************************************/
 
 #include "Solver.h"
+#include "Parallel.h"
+#include "Kernels.h"
+#include "Profiler.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
 #include <cmath>
 #include <cfloat>
 #include <iostream>
@@ -17,71 +24,749 @@
 
 using namespace std;
 
-// LDLT facterization
-void CLDLTSolver::LDLT()
+//	C = sum(a[k]*b[k], k=1:n) for two column segments a[k] = K(r-k,i) and b[k] = K(r-k,j)
+inline double ColumnDot(const double* a, const double* b, unsigned int n)
+{
+	return CKernels::Dot(a + 1, b + 1, n);
+}
+
+// LDLT facterization with the selected scheme
+// The columns 1:FirstColumn-1 hold their factors already, e.g. those of a previous factorization
+// of a matrix that differs only in the columns FirstColumn:N. All schemes perform the same
+// operations on every entry, so the factors are those of a complete factorization.
+void CLDLTSolver::LDLT(unsigned int FirstColumn)
+{
+	CProfileScope Scope("CLDLTSolver::LDLT");
+
+	if (K.IsOutOfCore())
+	{
+		OutOfCoreLDLT(FirstColumn);
+		return;
+	}
+
+	switch (Scheme_)
+	{
+		case BlockedReduction:
+			BlockedLDLT(FirstColumn);
+			break;
+		case ParallelReduction:
+			ParallelLDLT(FirstColumn);
+			break;
+		default:
+			ColumnLDLT(FirstColumn);
+			break;
+	}
+}
+
+// LDLT facterization column by column
+void CLDLTSolver::ColumnLDLT(unsigned int FirstColumn)
+{
+	ReduceColumns(max(FirstColumn, 2u), K.dim());
+}
+
+// Reduce the columns First:Last one by one, the columns 1:First-1 being already reduced
+void CLDLTSolver::ReduceColumns(unsigned int First, unsigned int Last)
 {
-	unsigned int N = K.dim();
     unsigned int* ColumnHeights = K.GetColumnHeights();   // Column Hights
+    size_t* DiagonalAddress = K.GetDiagonalAddress();
+    double* data = K.data();
 
-	for (unsigned int j = 2; j <= N; j++)      // Loop for column 2:n (Numbering starting from 1)
+	for (unsigned int j = max(First, 2u); j <= Last; j++)      // Loop for column First:Last (Numbering starting from 1)
 	{
         // Row number of the first non-zero element in column j (Numbering starting from 1)
 		unsigned int mj = j - ColumnHeights[j-1];
+		double* Cj = data + DiagonalAddress[j-1] - 1;	// Cj[j-r] = K(r,j)
         
 		for (unsigned int i = mj+1; i <= j-1; i++)	// Loop for mj+1:j-1 (Numbering starting from 1)
 		{
             // Row number of the first nonzero element in column i (Numbering starting from 1)
 			unsigned int mi = i - ColumnHeights[i-1];
+			double* Ci = data + DiagonalAddress[i-1] - 1;	// Ci[i-r] = K(r,i)
 
-			double C = 0.0;
-			for (unsigned int r = max(mi, mj); r <= i-1; r++)
-				C += K(r,i) * K(r,j);		// C += L_ri * U_rj
-
-			K(i,j) -= C;	// U_ij = K_ij - C
+			Cj[j-i] -= ColumnDot(Ci, Cj + (j - i), i - max(mi, mj));	// U_ij = K_ij - sum(L_ri * U_rj, r=max(mi,mj):i-1)
 		}
 
 		for (unsigned int r = mj; r <= j-1; r++)	// Loop for mj:j-1 (column j)
 		{
-			double Lrj = K(r,j) / K(r,r);	// L_rj = U_rj / D_rr
-			K(j,j) -= Lrj * K(r,j);	// D_jj = K_jj - sum(L_rj*U_rj, r=mj:j-1)
-			K(r,j) = Lrj;
+			double Lrj = Cj[j-r] / data[DiagonalAddress[r-1] - 1];	// L_rj = U_rj / D_rr
+			Cj[0] -= Lrj * Cj[j-r];	// D_jj = K_jj - sum(L_rj*U_rj, r=mj:j-1)
+			Cj[j-r] = Lrj;
 		}
 
-        if (fabs(K(j,j)) <= FLT_MIN)
+        if (fabs(Cj[0]) <= FLT_MIN)
         {
             cerr << "*** Error *** Stiffness matrix is not positive definite !" << endl
             	 << "    Euqation no = " << j << endl
-            	 << "    Pivot = " << K(j,j) << endl;
+            	 << "    Pivot = " << Cj[0] << endl;
             
             exit(4);
         }
     }
 };
 
-// Solve displacement by back substitution
-void CLDLTSolver::BackSubstitution(double* Force)
+// Blocked LDLT facterization
+// Adjacent columns whose profiles reach the first column of the panel are grouped into a panel
+// of at most BlockSize_ columns. Each complete column on the left of the panel is then read once
+// to update all columns of the panel, instead of once per column as in ColumnLDLT. The operations
+// on every entry are performed in the same order as in ColumnLDLT, so both give the same factors.
+void CLDLTSolver::BlockedLDLT(unsigned int FirstColumn)
+{
+	ReducePanels(FirstColumn, K.dim());
+}
+
+// Reduce the columns First:Last by panels, the columns 1:First-1 being already reduced
+void CLDLTSolver::ReducePanels(unsigned int First, unsigned int Last)
+{
+    unsigned int* ColumnHeights = K.GetColumnHeights();   // Column Hights
+    size_t* DiagonalAddress = K.GetDiagonalAddress();
+    double* data = K.data();
+
+	for (unsigned int j0 = First; j0 <= Last; )
+	{
+//		Collect the columns j0:j1 of the panel and the row number mP of its first non-zero element
+		unsigned int j1 = j0;
+		unsigned int mP = j0 - ColumnHeights[j0-1];
+
+		while (j1 < Last && j1 + 1 - j0 < BlockSize_ && j1 + 1 - ColumnHeights[j1] <= j0)
+		{
+			j1++;
+			mP = min(mP, j1 - ColumnHeights[j1-1]);
+		}
+
+//		Update the panel by the complete columns mP+1:j0-1 on its left, row by row
+		for (unsigned int i = mP + 1; i < j0; i++)
+		{
+			unsigned int mi = i - ColumnHeights[i-1];
+			double* Ci = data + DiagonalAddress[i-1] - 1;	// Ci[k] = L_(i-k)i
+
+			for (unsigned int j = j0; j <= j1; j++)
+			{
+				unsigned int mj = j - ColumnHeights[j-1];
+				if (i <= mj)
+					continue;
+
+				double* Cj = data + DiagonalAddress[j-1] - 1 + (j - i);	// Cj[k] = U_(i-k)j
+
+				Cj[0] -= ColumnDot(Ci, Cj, i - max(mi, mj));	// U_ij = K_ij - sum(L_ri * U_rj)
+			}
+		}
+
+//		Reduce the columns of the panel one after another
+		for (unsigned int j = max(j0, 2u); j <= j1; j++)
+		{
+			unsigned int mj = j - ColumnHeights[j-1];
+			double* Cj = data + DiagonalAddress[j-1] - 1;	// Cj[j-r] = K(r,j)
+
+			for (unsigned int i = max(mj+1, j0); i <= j-1; i++)
+			{
+				unsigned int mi = i - ColumnHeights[i-1];
+				double* Ci = data + DiagonalAddress[i-1] - 1;
+
+				Cj[j-i] -= ColumnDot(Ci, Cj + (j - i), i - max(mi, mj));
+			}
+
+			for (unsigned int r = mj; r <= j-1; r++)	// Loop for mj:j-1 (column j)
+			{
+				double Lrj = Cj[j-r] / data[DiagonalAddress[r-1] - 1];	// L_rj = U_rj / D_rr
+				Cj[0] -= Lrj * Cj[j-r];	// D_jj = K_jj - sum(L_rj*U_rj, r=mj:j-1)
+				Cj[j-r] = Lrj;
+			}
+
+			if (fabs(Cj[0]) <= FLT_MIN)
+			{
+				cerr << "*** Error *** Stiffness matrix is not positive definite !" << endl
+					 << "    Euqation no = " << j << endl
+					 << "    Pivot = " << Cj[0] << endl;
+
+				exit(4);
+			}
+		}
+
+		j0 = j1 + 1;
+	}
+};
+
+// Parallel LDLT facterization
+// Column j can only be reduced after the columns mj:j-1 are complete, i.e. the column heights
+// define a dependency graph between columns. The columns are handed out to the threads in
+// increasing order, and each thread reduces its column row by row, waiting only until the
+// column of the current row is complete. Columns with disjoint profiles are therefore reduced
+// concurrently, and the rows of a column overlap with the reduction of the columns before it.
+// The operations on every entry are the same as in ColumnLDLT, so the factors are identical.
+void CLDLTSolver::ParallelLDLT(unsigned int FirstColumn)
 {
 	unsigned int N = K.dim();
     unsigned int* ColumnHeights = K.GetColumnHeights();   // Column Hights
+    size_t* DiagonalAddress = K.GetDiagonalAddress();
+    double* data = K.data();
+
+//	Complete[j] is set when column j has been reduced (Numbering starting from 1)
+	unique_ptr<atomic<bool>[]> Complete(new atomic<bool>[N + 1]);
+	for (unsigned int j = 0; j <= N; j++)
+		Complete[j].store(j < max(FirstColumn, 2u));
+
+	atomic<unsigned int> NextColumn(max(FirstColumn, 2u));
+
+//	Threads spin shortly on a column that is not complete yet, and then sleep until it is
+	mutex Lock;
+	condition_variable ColumnCompleted;
+
+	auto WaitFor = [&](unsigned int i)
+	{
+		for (unsigned int spin = 0; spin < 64; spin++)
+		{
+			if (Complete[i].load(memory_order_acquire))
+				return;
+
+			this_thread::yield();
+		}
+
+		unique_lock<mutex> Guard(Lock);
+		ColumnCompleted.wait(Guard, [&] { return Complete[i].load(memory_order_acquire); });
+	};
+
+	CParallel::For(0, CParallel::GetNumberOfThreads(), [&](unsigned int, unsigned int, unsigned int)
+	{
+		for (unsigned int j = NextColumn++; j <= N; j = NextColumn++)
+		{
+			unsigned int mj = j - ColumnHeights[j-1];
+			double* Cj = data + DiagonalAddress[j-1] - 1;	// Cj[j-r] = K(r,j)
+
+			for (unsigned int i = mj+1; i <= j-1; i++)	// Loop for mj+1:j-1
+			{
+				unsigned int mi = i - ColumnHeights[i-1];
+				double* Ci = data + DiagonalAddress[i-1] - 1;
+
+				WaitFor(i);
+				Cj[j-i] -= ColumnDot(Ci, Cj + (j - i), i - max(mi, mj));	// U_ij = K_ij - C
+			}
+
+			if (mj < j)
+				WaitFor(mj);
+
+			for (unsigned int r = mj; r <= j-1; r++)	// Loop for mj:j-1 (column j)
+			{
+				double Lrj = Cj[j-r] / data[DiagonalAddress[r-1] - 1];	// L_rj = U_rj / D_rr
+				Cj[0] -= Lrj * Cj[j-r];	// D_jj = K_jj - sum(L_rj*U_rj, r=mj:j-1)
+				Cj[j-r] = Lrj;
+			}
+
+			if (fabs(Cj[0]) <= FLT_MIN)
+			{
+				cerr << "*** Error *** Stiffness matrix is not positive definite !" << endl
+					 << "    Euqation no = " << j << endl
+					 << "    Pivot = " << Cj[0] << endl;
+
+				exit(4);
+			}
+
+			Complete[j].store(true, memory_order_release);
+
+			{
+				lock_guard<mutex> Guard(Lock);
+			}
+			ColumnCompleted.notify_all();
+		}
+	});
+};
+
+// Number of multiply-adds of the factorization of the columns FirstColumn:N
+// The reduction of column j of height H_j takes about H_j*(H_j+1)/2 multiply-adds
+double CLDLTSolver::CountFactorization(unsigned int FirstColumn)
+{
+    unsigned int* ColumnHeights = K.GetColumnHeights();   // Column Hights
+
+	double Count = 0.0;
+	for (unsigned int j = max(FirstColumn, 1u); j <= K.dim(); j++)
+		Count += 0.5 * ColumnHeights[j-1] * (ColumnHeights[j-1] + 1.0);
+
+	return Count;
+}
+
+// Split the columns into blocks whose storage does not exceed a quarter of the memory budget
+// BlockStart_[b] is the first column of block b, and BlockStart_.back() = N + 1
+void CLDLTSolver::PartitionColumns()
+{
+	unsigned int N = K.dim();
+    size_t* DiagonalAddress = K.GetDiagonalAddress();
+
+	size_t BlockEntries = max(MemoryBudget_ / (4 * sizeof(double)), (size_t)1);
+
+	BlockStart_.clear();
+	for (unsigned int j = 1; j <= N; j++)
+		if (BlockStart_.empty() || DiagonalAddress[j] - DiagonalAddress[BlockStart_.back() - 1] > BlockEntries)
+			BlockStart_.push_back(j);
+
+	BlockStart_.push_back(N + 1);
+}
+
+// Out of core LDLT facterization
+// The matrix is reduced block by block with the selected scheme. The next block is read
+// asynchronously while the current one is reduced, and the columns left of the first row
+// of all remaining columns are released, since they are not used again in the factorization.
+// The columns needed at any time are therefore those of the current and the next block, and
+// those within the profile of the remaining columns.
+void CLDLTSolver::OutOfCoreLDLT(unsigned int FirstColumn)
+{
+	unsigned int N = K.dim();
+    unsigned int* ColumnHeights = K.GetColumnHeights();   // Column Hights
+
+	PartitionColumns();
+
+//	FirstRow[j-1] = min(mk, k=j:N), the first row used by the columns j:N
+	vector<unsigned int> FirstRow(N + 1, N + 1);
+	for (unsigned int j = N; j >= 1; j--)
+		FirstRow[j-1] = min(FirstRow[j], j - ColumnHeights[j-1]);
+
+	unsigned int Released = 1;	// The columns 1:Released-1 have been released
+
+//	The blocks on the left of FirstColumn are skipped
+	size_t b0 = 0;
+	while (BlockStart_[b0+1] <= FirstColumn && b0 + 2 < BlockStart_.size())
+		b0++;
+
+	K.Prefetch(max(BlockStart_[b0], FirstColumn), BlockStart_[b0+1] - 1);
+
+	for (size_t b = b0; b + 1 < BlockStart_.size(); b++)
+	{
+		unsigned int First = max(BlockStart_[b], FirstColumn);
+		unsigned int Last = BlockStart_[b+1] - 1;
+
+		if (b + 2 < BlockStart_.size())
+			K.Prefetch(Last + 1, BlockStart_[b+2] - 1);
+
+		if (Scheme_ == BlockedReduction)
+			ReducePanels(First, Last);
+		else
+			ReduceColumns(First, Last);
+
+		K.Release(Released, FirstRow[Last] - 1);
+		Released = max(Released, FirstRow[Last]);
+	}
+}
+
+// Solve displacements of NRHS load cases by back substitution
+// The factor is read once for all load cases, and the innermost loops run over the load cases.
+// For a single load case, the loops over the column segments are the innermost loops instead.
+// An out of core factor is read block by block in each sweep, prefetching the next block.
+void CLDLTSolver::BackSubstitution(double* Force, unsigned int NRHS)
+{
+	CProfileScope Scope("CLDLTSolver::BackSubstitution");
+
+	unsigned int N = K.dim();
+    unsigned int* ColumnHeights = K.GetColumnHeights();   // Column Hights
+    size_t* DiagonalAddress = K.GetDiagonalAddress();
+    double* data = K.data();
+
+	if (K.IsOutOfCore())
+		PartitionColumns();
+	else
+		BlockStart_.assign({1u, N + 1});
+
+	size_t NumberOfBlocks = BlockStart_.size() - 1;
+
+	vector<double> Sum(NRHS);
+	vector<double> Diagonal(N);	// D_ii, collected in the reduction so that every column is read once per sweep
 
 //	Reduce right-hand-side load vector (LV = R)
-	for (unsigned int i = 2; i <= N; i++)	// Loop for i=2:N (Numering starting from 1)
+	for (size_t b = 0; b < NumberOfBlocks; b++)
 	{
-        unsigned int mi = i - ColumnHeights[i-1];
+		if (b + 1 < NumberOfBlocks)
+			K.Prefetch(BlockStart_[b+1], BlockStart_[b+2] - 1);
+
+		for (unsigned int i = BlockStart_[b]; i < BlockStart_[b+1]; i++)	// Loop for i=1:N (Numering starting from 1)
+		{
+			unsigned int mi = i - ColumnHeights[i-1];
+			double* Ci = data + DiagonalAddress[i-1] - 1;	// Ci[i-j] = L_ji
+			double* Vi = Force + (size_t)(i-1) * NRHS;
+
+			Diagonal[i-1] = Ci[0];
+
+			if (mi == i)
+				continue;
+
+			if (NRHS == 1)
+			{
+				Vi[0] -= CKernels::DotReverse(Ci + 1, Force + mi - 1, i - mi);	// V_i = R_i - sum_j (L_ji V_j)
+				continue;
+			}
+
+			fill(Sum.begin(), Sum.end(), 0.0);
 
-		for (unsigned int j = mi; j <= i-1; j++)	// Loop for j=mi:i-1
-			Force[i-1] -= K(j,i) * Force[j-1];	// V_i = R_i - sum_j (L_ji V_j)
+			for (unsigned int j = mi; j <= i-1; j++)	// Loop for j=mi:i-1
+				CKernels::Axpy(Sum.data(), Ci[i-j], Force + (size_t)(j-1) * NRHS, NRHS);
+
+			CKernels::Axpy(Vi, -1.0, Sum.data(), NRHS);	// V_i = R_i - sum_j (L_ji V_j)
+		}
+
+		K.Release(BlockStart_[b], BlockStart_[b+1] - 1);
 	}
 
 //	Back substitute (Vbar = D^(-1) V, L^T a = Vbar)
 	for (unsigned int i = 1; i <= N; i++)	// Loop for i=1:N
-		Force[i-1] /= K(i,i);	// Vbar = D^(-1) V
+	{
+		double Dii = Diagonal[i-1];
+		double* Vi = Force + (size_t)(i-1) * NRHS;
 
-	for (unsigned int j = N; j >= 2; j--)	// Loop for j=N:2
+		for (unsigned int k = 0; k < NRHS; k++)
+			Vi[k] /= Dii;	// Vbar = D^(-1) V
+	}
+
+	for (size_t b = NumberOfBlocks; b-- > 0; )
 	{
-        unsigned int mj = j - ColumnHeights[j-1];
+		if (b > 0)
+			K.Prefetch(BlockStart_[b-1], BlockStart_[b] - 1);
+
+		for (unsigned int j = BlockStart_[b+1] - 1; j >= max(BlockStart_[b], 2u); j--)	// Loop for j=N:2
+		{
+			unsigned int mj = j - ColumnHeights[j-1];
+			double* Cj = data + DiagonalAddress[j-1] - 1;	// Cj[j-i] = L_ij
+			double* Vj = Force + (size_t)(j-1) * NRHS;
+
+			if (NRHS == 1)
+			{
+				CKernels::AxpyReverse(Force + mj - 1, -Vj[0], Cj + 1, j - mj);	// a_i = Vbar_i - sum_j(L_ij Vbar_j)
+				continue;
+			}
+
+			for (unsigned int i = mj; i <= j-1; i++)	// Loop for i=mj:j-1
+				CKernels::Axpy(Force + (size_t)(i-1) * NRHS, -Cj[j-i], Vj, NRHS);	// a_i = Vbar_i - sum_j(L_ij Vbar_j)
+		}
 
-		for (unsigned int i = mj; i <= j-1; i++)	// Loop for i=mj:j-1
-			Force[i-1] -= K(i,j) * Force[j-1];	// a_i = Vbar_i - sum_j(L_ij Vbar_j)
+		K.Release(BlockStart_[b], BlockStart_[b+1] - 1);
 	}
 };
+
+const unsigned int CLowRankUpdate::MaximumRank;
+
+//	Calculate Z = K^(-1) P by back substituting the m columns of P as load cases, and the
+//	LU factorization of I + C W with partial pivoting
+bool CLowRankUpdate::Factorize()
+{
+	CProfileScope Scope("CLowRankUpdate::Factorize");
+
+	unsigned int m = GetRank();
+
+	if (!m)
+		return true;
+
+	Z_.assign((size_t)NEQ_ * m, 0.0);
+	for (unsigned int a = 0; a < m; a++)
+		Z_[(size_t)(Equations_[a] - 1) * m + a] = 1.0;
+
+	Solver_.BackSubstitution(Z_.data(), m);
+
+//	I + C W, where W_cb = Z(Equations_c, b)
+	LU_.assign((size_t)m * m, 0.0);
+	double Norm = 1.0;	// Largest entry of I and C W, to which the pivots are compared
+
+	for (unsigned int a = 0; a < m; a++)
+	{
+		double* Row = LU_.data() + (size_t)a * m;
+
+		for (unsigned int c = 0; c < m; c++)
+			CKernels::Axpy(Row, Update_[(size_t)a * m + c], Z_.data() + (size_t)(Equations_[c] - 1) * m, m);
+
+		for (unsigned int b = 0; b < m; b++)
+			Norm = max(Norm, fabs(Row[b]));
+
+		Row[a] += 1.0;
+	}
+
+	Pivots_.resize(m);
+
+	for (unsigned int k = 0; k < m; k++)
+	{
+		unsigned int p = k;
+		for (unsigned int i = k + 1; i < m; i++)
+			if (fabs(LU_[(size_t)i * m + k]) > fabs(LU_[(size_t)p * m + k]))
+				p = i;
+
+		Pivots_[k] = p;
+
+//		A pivot that cancels to the level of the rounding errors of Z means a singular updated matrix
+		if (fabs(LU_[(size_t)p * m + k]) <= 1.0E-12 * Norm)
+			return false;
+
+		if (p != k)
+			swap_ranges(LU_.begin() + (size_t)k * m, LU_.begin() + (size_t)(k + 1) * m, LU_.begin() + (size_t)p * m);
+
+		double* Rowk = LU_.data() + (size_t)k * m;
+
+		for (unsigned int i = k + 1; i < m; i++)
+		{
+			double* Rowi = LU_.data() + (size_t)i * m;
+
+			Rowi[k] /= Rowk[k];
+			CKernels::Axpy(Rowi + k + 1, -Rowi[k], Rowk + k + 1, m - k - 1);
+		}
+	}
+
+	return true;
+}
+
+//	a = y - Z u, where (I + C W) u = C P(T) y is solved for all load cases together
+void CLowRankUpdate::Correct(double* Force, unsigned int NRHS)
+{
+	CProfileScope Scope("CLowRankUpdate::Correct");
+
+	unsigned int m = GetRank();
+
+	if (!m)
+		return;
+
+	vector<double> U((size_t)m * NRHS, 0.0);	// U[a*NRHS + k] = u_a of load case k
+
+//	s = C P(T) y
+	for (unsigned int a = 0; a < m; a++)
+		for (unsigned int c = 0; c < m; c++)
+			CKernels::Axpy(U.data() + (size_t)a * NRHS, Update_[(size_t)a * m + c],
+						   Force + (size_t)(Equations_[c] - 1) * NRHS, NRHS);
+
+//	Forward and back substitution with the LU factors
+	for (unsigned int k = 0; k < m; k++)
+		if (Pivots_[k] != k)
+			swap_ranges(U.begin() + (size_t)k * NRHS, U.begin() + (size_t)(k + 1) * NRHS,
+						U.begin() + (size_t)Pivots_[k] * NRHS);
+
+	for (unsigned int i = 1; i < m; i++)
+		for (unsigned int j = 0; j < i; j++)
+			CKernels::Axpy(U.data() + (size_t)i * NRHS, -LU_[(size_t)i * m + j], U.data() + (size_t)j * NRHS, NRHS);
+
+	for (unsigned int i = m; i-- > 0; )
+	{
+		double* Ui = U.data() + (size_t)i * NRHS;
+
+		for (unsigned int j = i + 1; j < m; j++)
+			CKernels::Axpy(Ui, -LU_[(size_t)i * m + j], U.data() + (size_t)j * NRHS, NRHS);
+
+		for (unsigned int k = 0; k < NRHS; k++)
+			Ui[k] /= LU_[(size_t)i * m + i];
+	}
+
+//	a = y - Z u
+	for (unsigned int i = 0; i < NEQ_; i++)
+	{
+		const double* Zi = Z_.data() + (size_t)i * m;
+		double* Vi = Force + (size_t)i * NRHS;
+
+		if (NRHS == 1)
+		{
+			Vi[0] -= CKernels::Dot(Zi, U.data(), m);
+			continue;
+		}
+
+		for (unsigned int b = 0; b < m; b++)
+			CKernels::Axpy(Vi, -Zi[b], U.data() + (size_t)b * NRHS, NRHS);
+	}
+}
+
+//	Constructor
+CPCGSolver::CPCGSolver(CSparseMatrix<double>* K, Preconditioners Preconditioner, double Tolerance,
+					   unsigned int MaxIterations)
+	: K(*K), Preconditioner_(Preconditioner), Tolerance_(Tolerance), MaxIterations_(MaxIterations),
+	  Iterations_(0), Residual_(0.0)
+{
+	if (!MaxIterations_)
+		MaxIterations_ = max(10 * K->dim(), 1000u);
+}
+
+//	Calculate the preconditioner of the stiffness matrix
+void CPCGSolver::Factorize()
+{
+	CProfileScope Scope("CPCGSolver::Factorize");
+
+	unsigned int N = K.dim();
+	size_t* RowStart = K.GetRowStart();
+	unsigned int* ColumnIndices = K.GetColumnIndices();
+	double* data = K.data();
+
+//	Both preconditioners need a positive diagonal (the first entry of each row)
+	for (unsigned int i = 0; i < N; i++)
+		if (data[RowStart[i]] <= 0.0)
+		{
+			cerr << "*** Error *** Stiffness matrix is not positive definite !" << endl
+				 << "    Euqation no = " << i + 1 << endl
+				 << "    Pivot = " << data[RowStart[i]] << endl;
+
+			exit(4);
+		}
+
+	if (Preconditioner_ == JacobiPreconditioner)
+	{
+		M_.resize(N);
+		for (unsigned int i = 0; i < N; i++)
+			M_[i] = 1.0 / data[RowStart[i]];
+
+		return;
+	}
+
+//	Incomplete Cholesky factorization U(T)*U of K + Shift*diag(K) on the sparsity pattern of K.
+//	The diagonal shift is only applied (and then doubled) when a pivot is not positive, at most
+//	MaxShifts times, after which K + Shift*diag(K) is diagonally dominant for any practical K.
+	const unsigned int MaxShifts = 30;
+
+	double Shift = 0.0;
+	for (unsigned int Retry = 0; ; Retry++, Shift = (Shift == 0.0) ? 1.0E-3 : 2.0 * Shift)
+	{
+		M_.assign(data, data + K.size());
+		for (unsigned int i = 0; i < N; i++)
+			M_[RowStart[i]] *= 1.0 + Shift;
+
+		bool Positive = true;
+
+		for (unsigned int i = 0; i < N; i++)
+		{
+			size_t Diag = RowStart[i];
+			size_t End = RowStart[i+1];
+
+			if (M_[Diag] <= 0.0)
+			{
+				if (Retry == MaxShifts)
+				{
+					cerr << "*** Error *** Stiffness matrix is not positive definite !" << endl
+						 << "    Euqation no = " << i + 1 << endl
+						 << "    Pivot = " << M_[Diag] << endl;
+
+					exit(4);
+				}
+
+				Positive = false;
+				break;
+			}
+
+			double Uii = sqrt(M_[Diag]);
+			M_[Diag] = Uii;
+
+			for (size_t k = Diag + 1; k < End; k++)
+				M_[k] /= Uii;	// U_ij = K_ij / U_ii
+
+//			K_jl -= U_ij * U_il for all entries (j,l), i < j <= l, in the sparsity pattern
+			for (size_t k = Diag + 1; k < End; k++)
+			{
+				unsigned int j = ColumnIndices[k] - 1;
+				double Uij = M_[k];
+
+				size_t p = RowStart[j];
+				size_t pEnd = RowStart[j+1];
+
+				for (size_t l = k; l < End && p < pEnd; l++)
+				{
+					while (p < pEnd && ColumnIndices[p] < ColumnIndices[l])
+						p++;
+
+					if (p < pEnd && ColumnIndices[p] == ColumnIndices[l])
+						M_[p] -= Uij * M_[l];
+				}
+			}
+		}
+
+		if (Positive)
+			break;
+	}
+}
+
+//	Apply the preconditioner z = M^(-1) r
+void CPCGSolver::Precondition(const double* r, double* z)
+{
+	unsigned int N = K.dim();
+
+	if (Preconditioner_ == JacobiPreconditioner)
+	{
+		for (unsigned int i = 0; i < N; i++)
+			z[i] = M_[i] * r[i];
+
+		return;
+	}
+
+	size_t* RowStart = K.GetRowStart();
+	unsigned int* ColumnIndices = K.GetColumnIndices();
+
+//	Forward substitution U(T) y = r
+	for (unsigned int i = 0; i < N; i++)
+		z[i] = r[i];
+
+	for (unsigned int i = 0; i < N; i++)
+	{
+		z[i] /= M_[RowStart[i]];
+
+		for (size_t k = RowStart[i] + 1; k < RowStart[i+1]; k++)
+			z[ColumnIndices[k] - 1] -= M_[k] * z[i];
+	}
+
+//	Back substitution U z = y
+	for (unsigned int i = N; i-- > 0; )
+	{
+		double s = z[i];
+
+		for (size_t k = RowStart[i] + 1; k < RowStart[i+1]; k++)
+			s -= M_[k] * z[ColumnIndices[k] - 1];
+
+		z[i] = s / M_[RowStart[i]];
+	}
+}
+
+//	Solve the displacement for the load vector Force, which is overwritten by the displacement
+bool CPCGSolver::Solve(double* Force)
+{
+	CProfileScope Scope("CPCGSolver::Solve");
+
+	unsigned int N = K.dim();
+
+	auto Dot = [N](const double* a, const double* b)
+	{
+		double s = 0.0;
+		for (unsigned int i = 0; i < N; i++)
+			s += a[i] * b[i];
+
+		return s;
+	};
+
+	vector<double> r(Force, Force + N);		// Residual R - K a
+	vector<double> z(N), p(N), q(N);
+
+	double* a = Force;						// Displacement
+	for (unsigned int i = 0; i < N; i++)
+		a[i] = 0.0;
+
+	Iterations_ = 0;
+	Residual_ = 0.0;
+
+	double NormR = sqrt(Dot(r.data(), r.data()));
+	if (NormR == 0.0)
+		return true;
+
+	Precondition(r.data(), z.data());
+	p = z;
+
+	double rz = Dot(r.data(), z.data());
+
+	for (Iterations_ = 1; Iterations_ <= MaxIterations_; Iterations_++)
+	{
+		K.Multiply(p.data(), q.data());
+
+		double alpha = rz / Dot(p.data(), q.data());
+
+		for (unsigned int i = 0; i < N; i++)
+		{
+			a[i] += alpha * p[i];
+			r[i] -= alpha * q[i];
+		}
+
+		Residual_ = sqrt(Dot(r.data(), r.data())) / NormR;
+		if (Residual_ <= Tolerance_)
+			return true;
+
+		Precondition(r.data(), z.data());
+
+		double rzNew = Dot(r.data(), z.data());
+		double beta = rzNew / rz;
+		rz = rzNew;
+
+		for (unsigned int i = 0; i < N; i++)
+			p[i] = z[i] + beta * p[i];
+	}
+
+	Iterations_ = MaxIterations_;
+	return false;
+}
@@ -0,0 +1,320 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#include "Tokenizer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+
+//	Exact powers of ten of the fast conversion of floating point numbers
+static const double PowersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+									 1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+									 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline bool IsSpace(char c)
+{
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+inline bool IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+//	Map the input data file FileName
+bool CTokenizer::Open(const string& FileName)
+{
+	if (!File_.Open(FileName))
+		return false;
+
+	Current_ = File_.data();
+	End_ = Current_ + File_.size();
+	Fail_ = false;
+
+	return true;
+}
+
+//	Skip white space, set the failure flag at the end of the data
+inline bool CTokenizer::SkipSpace()
+{
+	if (Fail_)
+		return false;
+
+	while (Current_ < End_ && IsSpace(*Current_))
+		Current_++;
+
+	if (Current_ == End_)
+		Fail_ = true;
+
+	return !Fail_;
+}
+
+//	Return true if only white space is left
+bool CTokenizer::AtEnd()
+{
+	while (Current_ < End_ && IsSpace(*Current_))
+		Current_++;
+
+	return Current_ == End_;
+}
+
+//	Split the next Count non-blank lines into Parts contiguous ranges of whole lines
+//	Blank lines are attached to the range of the line before them
+bool CTokenizer::SplitLines(unsigned int Count, unsigned int Parts, vector<const char*>& Bounds)
+{
+	Bounds.assign(Parts + 1, nullptr);
+
+	const char* p = Current_;
+	unsigned int Part = 0;
+
+	for (unsigned int Line = 0; Line < Count; Line++)
+	{
+		while (p < End_ && IsSpace(*p))
+			p++;
+
+		if (p == End_)
+			return false;
+
+		while (Part < Parts && (unsigned long long)Count * Part / Parts == Line)
+			Bounds[Part++] = p;
+
+		const char* EndOfLine = (const char*)memchr(p, '\n', End_ - p);
+		p = EndOfLine ? EndOfLine + 1 : End_;
+	}
+
+	Bounds[Parts] = p;
+
+	return true;
+}
+
+//	Read the rest of the current line into s, storing at most n-1 characters
+void CTokenizer::getline(char* s, size_t n)
+{
+	size_t Length = 0;
+
+	while (Current_ < End_ && *Current_ != '\n')
+	{
+		if (Length + 1 < n)
+			s[Length++] = *Current_;
+
+		Current_++;
+	}
+
+	if (Current_ < End_)
+		Current_++;
+
+	if (n)
+		s[Length] = '\0';
+}
+
+//	Return the rest of the current line, and extract the end of line
+string CTokenizer::GetRestOfLine()
+{
+	const char* First = Current_;
+
+	while (Current_ < End_ && *Current_ != '\n')
+		Current_++;
+
+	string Line(First, Current_);
+
+	if (Current_ < End_)
+		Current_++;
+
+	return Line;
+}
+
+//	Extract an unsigned integer
+//	As for the stream extraction, a negative number is converted modulo 2^32
+CTokenizer& CTokenizer::operator>>(unsigned int& Value)
+{
+	if (!SkipSpace())
+		return *this;
+
+	bool Negative = *Current_ == '-';
+	if (*Current_ == '-' || *Current_ == '+')
+		Current_++;
+
+	if (Current_ == End_ || !IsDigit(*Current_))
+	{
+		Value = 0;
+		Fail_ = true;
+		return *this;
+	}
+
+	unsigned long long N = 0;
+	while (Current_ < End_ && IsDigit(*Current_))
+	{
+		N = N * 10 + (*Current_++ - '0');
+
+		if (N > UINT_MAX)
+		{
+			while (Current_ < End_ && IsDigit(*Current_))
+				Current_++;
+
+			Value = UINT_MAX;
+			Fail_ = true;
+			return *this;
+		}
+	}
+
+	Value = Negative ? (unsigned int)(0 - N) : (unsigned int)N;
+
+	return *this;
+}
+
+//	Extract an integer
+CTokenizer& CTokenizer::operator>>(int& Value)
+{
+	if (!SkipSpace())
+		return *this;
+
+	bool Negative = *Current_ == '-';
+	if (*Current_ == '-' || *Current_ == '+')
+		Current_++;
+
+	if (Current_ == End_ || !IsDigit(*Current_))
+	{
+		Value = 0;
+		Fail_ = true;
+		return *this;
+	}
+
+	long long N = 0;
+	while (Current_ < End_ && IsDigit(*Current_))
+	{
+		N = N * 10 + (*Current_++ - '0');
+
+		if (N > (long long)INT_MAX + 1 || (!Negative && N > INT_MAX))
+		{
+			while (Current_ < End_ && IsDigit(*Current_))
+				Current_++;
+
+			Value = Negative ? INT_MIN : INT_MAX;
+			Fail_ = true;
+			return *this;
+		}
+	}
+
+	Value = (int)(Negative ? -N : N);
+
+	return *this;
+}
+
+//	Extract a floating point number
+//	The number [+-]digits[.digits][(e|E)[+-]digits] is scanned, and its significant digits are
+//	collected. If they fit in 53 bits and the decimal exponent is at most 22 in magnitude, the
+//	number is exactly m*10^e or m/10^e rounded once, which is the correctly rounded result.
+CTokenizer& CTokenizer::operator>>(double& Value)
+{
+	if (!SkipSpace())
+		return *this;
+
+	const char* First = Current_;
+	const char* p = Current_;
+
+	bool Negative = *p == '-';
+	if (*p == '-' || *p == '+')
+		p++;
+
+	unsigned long long Mantissa = 0;
+	int Digits = 0;			// Significant digits in Mantissa
+	int Exponent = 0;		// Decimal exponent of Mantissa
+	bool Exact = true;		// Mantissa holds all significant digits
+	bool AnyDigit = false;
+
+	for (; p < End_ && IsDigit(*p); p++)
+	{
+		AnyDigit = true;
+
+		if (Mantissa == 0 && *p == '0')
+			continue;
+
+		if (Digits < 19)
+		{
+			Mantissa = Mantissa * 10 + (*p - '0');
+			Digits++;
+		}
+		else
+		{
+			Exponent++;
+			Exact = Exact && *p == '0';
+		}
+	}
+
+	if (p < End_ && *p == '.')
+	{
+		for (p++; p < End_ && IsDigit(*p); p++)
+		{
+			AnyDigit = true;
+
+			if (Mantissa == 0 && *p == '0')
+			{
+				Exponent--;
+				continue;
+			}
+
+			if (Digits < 19)
+			{
+				Mantissa = Mantissa * 10 + (*p - '0');
+				Digits++;
+				Exponent--;
+			}
+			else
+				Exact = Exact && *p == '0';
+		}
+	}
+
+	if (!AnyDigit)
+	{
+		Value = 0.0;
+		Fail_ = true;
+		return *this;
+	}
+
+	if (p < End_ && (*p == 'e' || *p == 'E'))
+	{
+		const char* q = p + 1;
+
+		bool NegativeExponent = q < End_ && *q == '-';
+		if (q < End_ && (*q == '-' || *q == '+'))
+			q++;
+
+		if (q < End_ && IsDigit(*q))
+		{
+			int E = 0;
+			for (; q < End_ && IsDigit(*q); q++)
+				if (E < 100000)
+					E = E * 10 + (*q - '0');
+
+			Exponent += NegativeExponent ? -E : E;
+			p = q;
+		}
+	}
+
+	Current_ = p;
+
+	if (Exact && Mantissa <= (1ULL << 53) && Exponent >= -22 && Exponent <= 22)
+	{
+		double M = (double)Mantissa;
+		Value = Exponent >= 0 ? M * PowersOfTen[Exponent] : M / PowersOfTen[-Exponent];
+
+		if (Negative)
+			Value = -Value;
+
+		return *this;
+	}
+
+//	Convert all other numbers with strtod, from a terminated copy of the number
+	string Number(First, p);
+	Value = strtod(Number.c_str(), nullptr);
+
+	return *this;
+}
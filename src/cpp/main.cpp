@@ -11,24 +11,209 @@
 #include "Domain.h"
 #include "Bar.h"
 #include "Outputter.h"
-#include "Clock.h"
+#include "Profiler.h"
+#include "Parallel.h"
+#include "Kernels.h"
+#include "FactorCache.h"
+
+#include <cstdlib>
 
 using namespace std;
 
+//	Print help message
+void PrintUsage()
+{
+	cout << "Usage: stap++ [options] InputFileName\n"
+		 << "    InputFileName is a text (.dat) or binary (.bdat) input data file\n"
+		 << "Options:\n"
+		 << "    -convert                 Convert the text input data file to a binary one (.bdat) and exit\n"
+		 << "    -quiet                   Do not echo the output file to the console\n"
+		 << "    -results text | binary | both\n"
+		 << "                             Write the displacements and stresses to the output file, to a\n"
+		 << "                             binary results file (.bres), or to both (default text)\n"
+		 << "    -t N                     Number of threads used in the solution (0 : all cores, default 1)\n"
+		 << "    -ldlt column | blocked | parallel\n"
+		 << "                             Factorization scheme of the LDLT solver (default column)\n"
+		 << "    -reorder                 Renumber the equations by reverse Cuthill-McKee ordering\n"
+		 << "    -solver ldlt | pcg       Solver of the equilibrium equations (overrides the control line)\n"
+		 << "    -pc jacobi | ic          Preconditioner of the PCG solver (default jacobi)\n"
+		 << "    -tol TOL                 Relative residual tolerance of the PCG solver (default 1e-10)\n"
+		 << "    -ooc MB                  Store the skyline in a scratch file in $TMPDIR, using at most MB\n"
+		 << "                             megabytes of memory for it in the LDLT solver\n"
+		 << "    -memlimit MB             Limit the memory of the solution, estimated before the matrices are\n"
+		 << "                             allocated, to MB megabytes. If it is exceeded, the skyline is stored\n"
+		 << "                             out of core, or the PCG solver is used\n"
+		 << "    -memabort                Stop instead if the memory limit is exceeded\n"
+		 << "    -cache                   Keep the factorized skyline in a cache file (.fac), and reuse it in\n"
+		 << "                             later runs with the same nodes, elements and materials. A run\n"
+		 << "                             with the same nodes updates it for the elements that changed\n"
+		 << "    -simd scalar | avx2 | avx512\n"
+		 << "                             Instruction set of the solver kernels (default: fastest supported)\n"
+		 << "    -profile                 Write the wall clock and CPU time, memory and hardware counters of\n"
+		 << "                             the solution phases to a Chrome trace file (.trace.json)\n";
+}
+
 int main(int argc, char *argv[])
 {
-	if (argc != 2) //  Print help message
+	if (argc < 2) //  Print help message
 	{
-	    cout << "Usage: stap++ InputFileName\n";
+	    PrintUsage();
 		exit(1);
 	}
 
-	string filename(argv[1]);
+	CDomain* FEMData = CDomain::GetInstance();
+
+	LDLTSchemes Scheme = ColumnReduction;
+
+	int SolverOption = -1;	// Solver type given on the command line
+	Preconditioners Preconditioner = JacobiPreconditioner;
+	double Tolerance = 1.0E-10;
+	bool Convert = false;	// Convert the input data file to a binary one
+	bool Cache = false;	// Reuse the factorized stiffness matrix of a previous run
+	bool Profile = false;	// Write the phases of the solution to a trace file
+	string Results = "text";	// Format of the displacements and stresses
+
+//	Read command line options given before the input file name
+	for (int arg = 1; arg < argc - 1; arg++)
+	{
+		string option(argv[arg]);
+
+		if (option == "-t" && arg + 1 < argc - 1)
+			CParallel::SetNumberOfThreads(atoi(argv[++arg]));
+		else if (option == "-ldlt" && arg + 1 < argc - 1)
+		{
+			string scheme(argv[++arg]);
+
+			if (scheme == "column")
+				Scheme = ColumnReduction;
+			else if (scheme == "blocked")
+				Scheme = BlockedReduction;
+			else if (scheme == "parallel")
+				Scheme = ParallelReduction;
+			else
+			{
+				cout << "*** Error *** Invalid LDLT scheme: " << scheme << endl;
+				exit(1);
+			}
+		}
+		else if (option == "-results" && arg + 1 < argc - 1)
+		{
+			Results = argv[++arg];
+
+			if (Results != "text" && Results != "binary" && Results != "both")
+			{
+				cout << "*** Error *** Invalid results format: " << Results << endl;
+				exit(1);
+			}
+		}
+		else if (option == "-quiet")
+			COutputter::SetConsole(false);
+		else if (option == "-convert")
+			Convert = true;
+		else if (option == "-cache")
+			Cache = true;
+		else if (option == "-profile")
+		{
+			Profile = true;
+			CProfiler::Enable(true);
+		}
+		else if (option == "-reorder")
+			FEMData->SetReorder(true);
+		else if (option == "-solver" && arg + 1 < argc - 1)
+		{
+			string solver(argv[++arg]);
+
+			if (solver == "ldlt")
+				SolverOption = SkylineLDLT;
+			else if (solver == "pcg")
+				SolverOption = SparsePCG;
+			else
+			{
+				cout << "*** Error *** Invalid solver: " << solver << endl;
+				exit(1);
+			}
+		}
+		else if (option == "-pc" && arg + 1 < argc - 1)
+		{
+			string pc(argv[++arg]);
+
+			if (pc == "jacobi")
+				Preconditioner = JacobiPreconditioner;
+			else if (pc == "ic")
+				Preconditioner = IncompleteCholesky;
+			else
+			{
+				cout << "*** Error *** Invalid preconditioner: " << pc << endl;
+				exit(1);
+			}
+		}
+		else if (option == "-tol" && arg + 1 < argc - 1)
+			Tolerance = atof(argv[++arg]);
+		else if (option == "-ooc" && arg + 1 < argc - 1)
+		{
+			double Budget = atof(argv[++arg]);
+
+			if (Budget <= 0)
+			{
+				cout << "*** Error *** Invalid memory budget: " << argv[arg] << endl;
+				exit(1);
+			}
+
+			FEMData->SetMemoryBudget((size_t)(Budget * 1048576));
+		}
+		else if (option == "-memlimit" && arg + 1 < argc - 1)
+		{
+			double Limit = atof(argv[++arg]);
+
+			if (Limit <= 0)
+			{
+				cout << "*** Error *** Invalid memory limit: " << argv[arg] << endl;
+				exit(1);
+			}
+
+			FEMData->SetMemoryLimit((size_t)(Limit * 1048576));
+		}
+		else if (option == "-memabort")
+			FEMData->SetMemoryAbort(true);
+		else if (option == "-simd" && arg + 1 < argc - 1)
+		{
+			string simd(argv[++arg]);
+			SIMDLevels Level;
+
+			if (simd == "scalar")
+				Level = ScalarKernels;
+			else if (simd == "avx2")
+				Level = AVX2Kernels;
+			else if (simd == "avx512")
+				Level = AVX512Kernels;
+			else
+			{
+				cout << "*** Error *** Invalid instruction set: " << simd << endl;
+				exit(1);
+			}
+
+			if (CKernels::SetLevel(Level) != Level)
+				cerr << "*** Warning *** " << simd << " is not supported, "
+					 << CKernels::GetLevelName(CKernels::GetLevel()) << " kernels are used instead !" << endl;
+		}
+		else
+		{
+			cout << "*** Error *** Invalid option: " << option << endl;
+			PrintUsage();
+			exit(1);
+		}
+	}
+
+	string filename(argv[argc - 1]);
     size_t found = filename.find_last_of('.');
 
+    string extension = ".dat";
+
     // If the input file name is provided with an extension
     if (found != std::string::npos) {
-        if (filename.substr(found) == ".dat")
+        extension = filename.substr(found);
+
+        if (extension == ".dat" || extension == ".bdat")
             filename = filename.substr(0, found);
         else {
             // The input file name must has an extension of 'dat'
@@ -38,13 +223,21 @@ int main(int argc, char *argv[])
         }
     }
 
-    string InFile = filename + ".dat";
+    string InFile = filename + extension;
 	string OutFile = filename + ".out";
 
-	CDomain* FEMData = CDomain::GetInstance();
+//	Wall clock times of the solution phases (the phases run on several threads)
+	double time_start = CProfiler::WallTime();
+	double cpu_start = CProfiler::CPUTime();
+
+//	Write the phases timed so far to the trace file
+	string TraceFile = filename + ".trace.json";
 
-    Clock timer;
-    timer.Start();
+	auto WriteTrace = [&]()
+	{
+		if (Profile && !CProfiler::WriteTrace(TraceFile))
+			cerr << "*** Warning *** Trace file " << TraceFile << " cannot be written !" << endl;
+	};
 
 //  Read data and define the problem domain
 	if (!FEMData->ReadData(InFile, OutFile))
@@ -52,67 +245,263 @@ int main(int argc, char *argv[])
 		cerr << "*** Error *** Data input failed!" << endl;
 		exit(1);
 	}
+
+//	Write the data read from the text input data file to a binary input data file
+	if (Convert)
+	{
+		if (extension == ".bdat")
+		{
+			cerr << "*** Error *** " << InFile << " is already a binary input data file !" << endl;
+			exit(1);
+		}
+
+		string BinaryFile = filename + ".bdat";
+		if (!FEMData->WriteBinaryData(BinaryFile))
+			exit(1);
+
+		COutputter::GetInstance()->Flush();
+
+		cout << "Binary input data file " << BinaryFile << " written in "
+			 << CProfiler::WallTime() - time_start << " s" << endl;
+
+		WriteTrace();
+		return 0;
+	}
+
+//	The solver type given on the command line overrides the one of the control line
+	if (SolverOption >= 0)
+		FEMData->SetSolverType((SolverTypes)SolverOption);
     
-    double time_input = timer.ElapsedTime();
+    double time_input = CProfiler::WallTime() - time_start;
 
     COutputter* Output = COutputter::GetInstance();
 
     if (!FEMData->GetMODEX())
     {
+//		Report the memory of the solution, and the solver selected for the memory limit
+		if (!FEMData->EstimateMemory())
+			cerr << "*** Warning *** Not enough memory for the solution within the memory limit !" << endl;
+
+		Output->OutputTotalSystemData();
+
         *Output << "Data check completed !" << endl << endl;
+
+        Output->Flush();
+        WriteTrace();
         return 0;
     }
 
+//	Write the displacements and stresses to a binary results file
+	string ResultsFile = filename + ".bres";
+
+	if (Results != "text" && !Output->OpenResults(ResultsFile, Results == "both"))
+	{
+		cerr << "*** Error *** File " << ResultsFile << " cannot be created !" << endl;
+		exit(3);
+	}
+
 //  Allocate global vectors and matrices, such as the Force, ColumnHeights,
 //  DiagonalAddress and StiffnessMatrix, and calculate the column heights
 //  and address of diagonal elements
 	FEMData->AllocateMatrices();
+
+//	Read the factorized stiffness matrix from the cache file, if it was written by a run with the
+//	same nodes, elements and materials and the same factorization options
+	string CacheFile = filename + ".fac";
+	uint64_t CacheKey = 0, NodeKey = 0;
+	bool Cached = false;
+
+//	The factorization of a model with the same nodes and skyline but other elements is either
+//	updated by CLowRankUpdate, or factorized again from the first equation of the changed elements
+	bool Updated = false;	// The cached factorization is updated by CLowRankUpdate
+	unsigned int FirstColumn = 1;	// First column of the factorization (1 : the whole matrix)
+	vector<unsigned int> UpdateEquations;
+	vector<double> StiffnessUpdate;
+	unsigned int ChangedElements = 0;
+
+	CLDLTSolver* Solver = nullptr;
+	CLowRankUpdate* Update = nullptr;
+	CPCGSolver* PCGSolver = nullptr;
+
+	if (FEMData->GetSolverType() == SkylineLDLT)
+	{
+		Solver = new CLDLTSolver(FEMData->GetStiffnessMatrix(), Scheme);
+		Solver->SetMemoryBudget(FEMData->GetMemoryBudget());
+	}
+
+	if (Cache && Solver)
+	{
+		unsigned int Options[] = {Scheme, CKernels::GetLevel(), FEMData->IsOutOfCore()};
+		CacheKey = CFactorCache::FNV1a(Options, sizeof(Options), FEMData->CalculateStructureHash());
+		NodeKey = CFactorCache::FNV1a(Options, sizeof(Options), FEMData->CalculateNodeHash());
+
+		Cached = CFactorCache::Read(CacheFile, CacheKey, *FEMData->GetStiffnessMatrix());
+
+		vector<char> Records;
+
+		if (!Cached && CFactorCache::ReadElements(CacheFile, NodeKey, Records) &&
+			FEMData->CalculateStiffnessUpdate(Records, CLowRankUpdate::MaximumRank, UpdateEquations,
+											  StiffnessUpdate, ChangedElements))
+		{
+			unsigned int NEQ = FEMData->GetNEQ();
+			unsigned int m = (unsigned int)UpdateEquations.size();
+
+//			Elements changed only on fixed degrees of freedom leave the stiffness matrix unchanged
+			if (!m)
+				Cached = CFactorCache::Read(CacheFile, NodeKey, *FEMData->GetStiffnessMatrix(), true);
+			else
+			{
+				unsigned int First = UpdateEquations[0];
+
+//				The multiply-adds of Z and of the corrections of all load cases are compared with
+//				those of the factorization of the columns First:NEQ
+				double Multiplications = 2.0 * m * ((double)FEMData->GetStiffnessMatrix()->size() +
+													(double)NEQ * FEMData->GetNLCASE());
+				bool LowRank = (m <= CLowRankUpdate::MaximumRank && Multiplications < Solver->CountFactorization(First));
+
+				if ((LowRank || First > 1) && CFactorCache::Read(CacheFile, NodeKey, *FEMData->GetStiffnessMatrix(), true))
+				{
+					Cached = Updated = LowRank;
+					FirstColumn = LowRank ? 1 : First;
+				}
+			}
+		}
+	}
     
-//  Assemble the banded gloabl stiffness matrix
-	FEMData->AssembleStiffnessMatrix();
+//  Assemble the banded gloabl stiffness matrix, or its columns FirstColumn:NEQ
+	if (!Cached)
+		FEMData->AssembleStiffnessMatrix(FirstColumn);
     
-    double time_assemble = timer.ElapsedTime();
+    double time_assemble = CProfiler::WallTime() - time_start;
 
 //  Solve the linear equilibrium equations for displacements
-	CLDLTSolver* Solver = new CLDLTSolver(FEMData->GetStiffnessMatrix());
-    
-//  Perform L*D*L(T) factorization of stiffness matrix
-    Solver->LDLT();
+	if (FEMData->GetSolverType() == SparsePCG)
+	{
+		PCGSolver = new CPCGSolver(FEMData->GetSparseStiffnessMatrix(), Preconditioner, Tolerance);
+
+//		Calculate the preconditioner
+		PCGSolver->Factorize();
+	}
+	else
+	{
+//		Perform L*D*L(T) factorization of stiffness matrix, and keep it in the cache file
+		if (!Cached)
+		{
+			Solver->LDLT(FirstColumn);
+
+			vector<char> Records;
+			if (Cache)
+				FEMData->GetElementRecords(Records);
+
+			if (Cache && !CFactorCache::Write(CacheFile, CacheKey, NodeKey, *FEMData->GetStiffnessMatrix(), Records))
+				cerr << "*** Warning *** Cache file " << CacheFile << " cannot be written !" << endl;
+		}
+		else if (Updated)
+		{
+//			Update the cached factorization for the changed elements
+			Update = new CLowRankUpdate(Solver, FEMData->GetNEQ(), UpdateEquations, StiffnessUpdate);
+
+			if (!Update->Factorize())
+			{
+				cerr << "*** Error *** Updated stiffness matrix is singular !" << endl;
+				exit(4);
+			}
+		}
 
 #ifdef _DEBUG_
-    Output->PrintStiffnessMatrix();
+		Output->PrintStiffnessMatrix();
 #endif
+	}
         
+    unsigned int NLCASE = FEMData->GetNLCASE();
+    unsigned int NumberOfCases = 1;     // Number of load cases in the current block
+
 //  Loop over for all load cases
-    for (unsigned int lcase = 0; lcase < FEMData->GetNLCASE(); lcase++)
+    for (unsigned int lcase = 0; lcase < NLCASE; lcase++)
     {
-//      Assemble righ-hand-side vector (force vector)
-        FEMData->AssembleForce(lcase + 1);
-            
-//      Reduce right-hand-side force vector and back substitute
-        Solver->BackSubstitution(FEMData->GetForce());
+        if (PCGSolver)
+        {
+//          Assemble righ-hand-side vector (force vector)
+            FEMData->AssembleForce(lcase + 1);
+
+//          Solve for the displacements iteratively
+            if (!PCGSolver->Solve(FEMData->GetForce()))
+                cerr << "*** Warning *** PCG solver did not converge in load case " << lcase + 1 << " !" << endl
+                     << "    Relative residual = " << PCGSolver->GetResidual() << endl;
+        }
+        else
+        {
+            unsigned int k = lcase % CDomain::NRHS;     // Position of the load case in its block
+
+//          Assemble the force vectors of a block of load cases, and reduce and back
+//          substitute them together in one pass over the factorized stiffness matrix
+            if (k == 0)
+            {
+                NumberOfCases = min(CDomain::NRHS, NLCASE - lcase);
+
+                FEMData->AssembleForceBlock(lcase + 1, NumberOfCases);
+                Solver->BackSubstitution(FEMData->GetForceBlock(), NumberOfCases);
+
+                if (Update)
+                    Update->Correct(FEMData->GetForceBlock(), NumberOfCases);
+            }
+
+            FEMData->ExtractDisplacement(k, NumberOfCases);
+        }
 
         *Output << " LOAD CASE" << setw(5) << lcase + 1 << endl << endl << endl;
 
+        if (PCGSolver)
+            *Output << "     PCG ITERATIONS . . . . . . . . . . . . . . . . . . = " << PCGSolver->GetIterations() << endl
+                    << "     RELATIVE RESIDUAL NORM . . . . . . . . . . . . . . = " << PCGSolver->GetResidual() << endl << endl;
+
 #ifdef _DEBUG_
         Output->PrintDisplacement();
 #endif
             
         Output->OutputNodalDisplacement();
 
-//      Calculate and output stresses of all elements
+//      Calculate the stresses of all elements, then output them
+        FEMData->CalculateStresses();
         Output->OutputElementStress();
     }
 
-    double time_solution = timer.ElapsedTime();
-    
-    timer.Stop();
+    if (!Output->CloseResults())
+        cerr << "*** Error *** File " << ResultsFile << " could not be written completely !" << endl;
+
+    double time_solution = CProfiler::WallTime() - time_start;
+    double cpu_solution = CProfiler::CPUTime() - cpu_start;
     
     *Output << "\n S O L U T I O N   T I M E   L O G   I N   S E C \n\n"
-            << "     TIME FOR INPUT PHASE = " << time_input << endl
-            << "     TIME FOR CALCULATION OF STIFFNESS MATRIX = " << time_assemble - time_input << endl
+            << "     TIME FOR INPUT PHASE = " << time_input << endl;
+
+//	Throughput of the text input data file, without the echo of the data
+	if (FEMData->GetInputSize() && FEMData->GetParseTime() > 0)
+		*Output << "     PARSE RATE OF INPUT DATA FILE (MB/S) = "
+				<< FEMData->GetInputSize() / 1048576.0 / FEMData->GetParseTime() << endl;
+
+	if (Updated)
+		*Output << "     FACTORIZED STIFFNESS MATRIX READ FROM CACHE FILE " << CacheFile << endl
+				<< "     UPDATED FOR " << ChangedElements << " CHANGED ELEMENTS ON "
+				<< UpdateEquations.size() << " EQUATIONS" << endl;
+	else if (FirstColumn > 1)
+		*Output << "     FACTORIZED STIFFNESS MATRIX READ FROM CACHE FILE " << CacheFile << endl
+				<< "     FACTORIZED AGAIN FROM EQUATION " << FirstColumn << " FOR " << ChangedElements
+				<< " CHANGED ELEMENTS" << endl;
+	else if (Cached)
+		*Output << "     FACTORIZED STIFFNESS MATRIX READ FROM CACHE FILE " << CacheFile << endl;
+
+    *Output << "     TIME FOR CALCULATION OF STIFFNESS MATRIX = " << time_assemble - time_input << endl
             << "     TIME FOR FACTORIZATION AND LOAD CASE SOLUTIONS = " << time_solution - time_assemble << endl << endl
-            << "     T O T A L   S O L U T I O N   T I M E = " << time_solution << endl << endl;
+            << "     T O T A L   S O L U T I O N   T I M E = " << time_solution << endl
+            << "     CPU TIME OF ALL THREADS = " << cpu_solution << endl << endl;
+
+	if (Profile)
+		*Output << "     PHASES OF THE SOLUTION WRITTEN TO TRACE FILE " << TraceFile << endl << endl;
+
+//	The output is written before the trace, so that the trace includes it
+	Output->Flush();
+	WriteTrace();
 
 	return 0;
 }
@@ -26,7 +26,7 @@ public:
 	~CBar();
 
 //!	Read element data from stream Input
-	virtual bool Read(ifstream& Input, CMaterial* MaterialSets, CNode* NodeList);
+	virtual bool Read(CTokenizer& Input, CMaterial* MaterialSets, CNode* NodeList);
 
 //!	Write element data to stream
 	virtual void Write(COutputter& output);
@@ -34,6 +34,15 @@ public:
 //!	Calculate element stiffness matrix
 	virtual void ElementStiffness(double* Matrix);
 
+//!	Calculate the stiffness matrix of a bar with nodes at XYZ1 and XYZ2 and material Material
+//!	(Upper triangular matrix, stored as an array column by colum, 21 entries)
+	static void Stiffness(const double* XYZ1, const double* XYZ2, const CBarMaterial& Material, double* Matrix);
+
 //!	Calculate element stress
 	virtual void ElementStress(double* stress, double* Displacement);
+
+//!	Calculate the stress of a bar with nodes at XYZ1 and XYZ2, material Material and location matrix
+//!	LocationMatrix for the global nodal displacement vector Displacement
+	static double Stress(const double* XYZ1, const double* XYZ2, const CBarMaterial& Material,
+						 const unsigned int* LocationMatrix, const double* Displacement);
 };
@@ -0,0 +1,122 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <fstream>
+#include <cstring>
+
+using namespace std;
+
+//!	CBinaryDeck class reads and writes the binary input data file (.bdat)
+/*!	The binary deck holds the same data as the text deck, as arrays in the byte order of
+	the machine that wrote it. Every array starts at a multiple of 8 bytes.
+	- Header : Magic (8 bytes), Version, ByteOrder (uint32), Title (256 bytes),
+			   NUMNP, NUMEG, NLCASE, MODEX, SolverType (uint32)
+	- Nodes : bcode (uint32 [NUMNP][3]), XYZ (double [NUMNP][3])
+	- For each load case : NL (uint32), node, dof (uint32 [NL]), load (double [NL])
+	- For each element group : ElementType, NUME, NUMMAT, NEN, NPROP (uint32),
+			   material properties (double [NUMMAT][NPROP]),
+			   nodes and material set of the elements (uint32 [NUME][NEN+1])
+	Nodes, load cases, material sets and elements are numbered by their position. The file
+	is mapped into memory and the arrays are copied directly into the domain */
+class CBinaryDeck
+{
+private:
+
+//!	Mapping of the deck being read
+	CMappedFile File_;
+
+//!	Current read position in bytes
+	size_t Position_;
+
+//!	Output stream of the deck being written
+	ofstream Output_;
+
+public:
+
+//!	Version of the format
+	const static unsigned int Version = 1;
+
+//!	Value of ByteOrder in the byte order of the writing machine
+	const static unsigned int ByteOrder = 0x01020304;
+
+//!	Return the magic number at the beginning of the deck (8 characters, not terminated)
+	static const char* Magic() { return "STAP++BD"; }
+
+//!	Constructor
+	CBinaryDeck() : Position_(0) {};
+
+//!	Open the binary deck FileName for reading
+	bool OpenForRead(const string& FileName) { Position_ = 0; return File_.Open(FileName); }
+
+//!	Open the binary deck FileName for writing
+	bool OpenForWrite(const string& FileName) { Output_.open(FileName, ios::binary); return (bool)Output_; }
+
+//!	Close the deck being written, return false if it could not be written completely
+	bool Close() { Output_.close(); return !Output_.fail(); }
+
+//!	Return a pointer to the next Count values of type T_, and advance the read position
+//!	Return nullptr if the deck is too short
+	template <class T_>
+	const T_* Read(size_t Count);
+
+//!	Read Count values of type T_ into Data, return false if the deck is too short
+	template <class T_>
+	bool Read(T_* Data, size_t Count);
+
+//!	Write Count values of type T_
+	template <class T_>
+	void Write(const T_* Data, size_t Count);
+
+//!	Write a single value of type T_
+	template <class T_>
+	void Write(T_ Value) { Write(&Value, 1); }
+};
+
+//	Return a pointer to the next Count values of type T_
+template <class T_>
+const T_* CBinaryDeck::Read(size_t Count)
+{
+	if (Count > (File_.size() - Position_) / sizeof(T_))
+		return nullptr;
+
+	const T_* Data = (const T_*)(File_.data() + Position_);
+
+	Position_ += (Count * sizeof(T_) + 7) / 8 * 8;
+	Position_ = Position_ < File_.size() ? Position_ : File_.size();
+
+	return Data;
+}
+
+//	Read Count values of type T_ into Data
+template <class T_>
+bool CBinaryDeck::Read(T_* Data, size_t Count)
+{
+	const T_* Source = Read<T_>(Count);
+	if (!Source)
+		return false;
+
+	memcpy(Data, Source, Count * sizeof(T_));
+
+	return true;
+}
+
+//	Write Count values of type T_, padded to a multiple of 8 bytes
+template <class T_>
+void CBinaryDeck::Write(const T_* Data, size_t Count)
+{
+	const char Padding[8] = {0};
+
+	Output_.write((const char*)Data, Count * sizeof(T_));
+	Output_.write(Padding, (8 - Count * sizeof(T_) % 8) % 8);
+}
@@ -18,18 +18,19 @@
 
 #pragma once
 
-#include <time.h>
+#include <chrono>
 #include <iostream>
 
 using namespace std;  
 
 //! Clock class for timing
+/*!	The clock measures wall clock time, since the CPU time of the process includes all threads */
 class Clock
 {
 
 private:
 
-	clock_t t0_, t1_;
+	chrono::steady_clock::time_point t0_, t1_;
 	double ct_;
 	bool st0_;   //!< Flag for Start method
 	bool st1_;   //!< Flag for Stop method
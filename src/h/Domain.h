@@ -16,11 +16,31 @@
 #include "Solver.h"
 #include "LoadCaseData.h"
 #include "SkylineMatrix.h"
+#include "SparseMatrix.h"
+#include "BinaryDeck.h"
+#include "Tokenizer.h"
+
+#include <vector>
+#include <cstdint>
 
 using namespace std;
 
 //!	Clear an array
-template <class type> void clear( type* a, unsigned int N );
+template <class type> void clear( type* a, size_t N );
+
+//!	Bytes of the arrays of the solution, calculated before the stiffness matrix is allocated
+struct CMemoryEstimate
+{
+	size_t Nodes;		// Nodes and their coordinates
+	size_t Elements;	// Elements, materials and flat arrays of all element groups
+	size_t Loads;		// Concentrated loads of all load cases
+	size_t Vectors;		// Force/displacement vectors of the solver
+	size_t Matrix;		// Stiffness matrix in memory, including the preconditioner of the PCG solver
+	size_t ScratchFile;	// Skyline in the scratch file of the out of core solver
+
+//!	Return the bytes held in memory
+	size_t Total() const { return Nodes + Elements + Loads + Vectors + Matrix; }
+};
 
 //!	Domain class : Define the problem domain
 /*!	Only a single instance of Domain class can be created */
@@ -31,8 +51,20 @@ private:
 //!	The instance of the Domain class
 	static CDomain* _instance;
 
-//!	Input file stream for reading data from input data file
-	ifstream Input;
+//!	Tokenizer for reading data from the text input data file
+	CTokenizer Input;
+
+//!	Size of the input data file in bytes
+	size_t InputSize;
+
+//!	Wall clock time spent reading the input data file, without the echo of the data
+	double ParseTime;
+
+//!	Wall clock time spent numbering (and renumbering) the equations
+	double NumberingTime;
+
+//!	Wall clock time spent calculating the column heights and diagonal addresses of the banded stiffness matrix
+	double ColumnHeightsTime;
 
 //!	Heading information for use in labeling the outpu
 	char Title[256]; 
@@ -42,12 +74,20 @@ private:
 		1 : Execution */
 	unsigned int MODEX;
 
+//!	Solver type (optional on the control line)
+/*!		0 : LDLT solver with skyline storage (default);
+		1 : PCG solver with compressed sparse row storage */
+	SolverTypes SolverType;
+
 //!	Total number of nodal points
 	unsigned int NUMNP;
 
 //!	List of all nodes in the domain
 	CNode* NodeList;
 
+//!	Coordinates of all nodes ([NUMNP][3]), read by the element kernels of the element groups
+	double* Coordinates;
+
 //!	Total number of element groups.
 /*! An element group consists of a convenient collection of elements with same type */
 	unsigned int NUMEG;
@@ -67,14 +107,54 @@ private:
 //!	Total number of equations in the system
 	unsigned int NEQ;
 
+//!	Renumber the equations with the reverse Cuthill-McKee algorithm before allocating the matrix
+	bool Reorder;
+
+//!	Size of the skyline and maximum half bandwidth for the equation numbers of the input order
+/*!	Only calculated when the equations are renumbered */
+	size_t NWKInput;
+	unsigned int MKInput;
+
+//!	Memory budget in bytes of the out of core skyline solver (0 : the skyline is held in memory)
+	size_t MemoryBudget;
+
+//!	Memory limit in bytes of the solution (0 : no limit)
+/*!	If the estimate exceeds it, the skyline is stored out of core, or the PCG solver is used,
+	unless MemoryAbort is set */
+	size_t MemoryLimit;
+
+//!	Stop instead of switching the solver when the memory limit is exceeded
+	bool MemoryAbort;
+
+//!	Number of entries of the sparse stiffness matrix counted with duplicates, an upper bound of NNZ
+	size_t SparseEntries;
+
+//!	Memory of the solution with the selected solver
+	CMemoryEstimate Memory;
+
 //!	Banded stiffness matrix
 /*! A one-dimensional array storing only the elements below the	skyline of the 
     global stiffness matrix. */
     CSkylineMatrix<double>* StiffnessMatrix;
 
+//!	Sparse stiffness matrix
+/*!	Compressed sparse row storage of the upper triangular part of the global stiffness
+	matrix, used by the PCG solver instead of the banded stiffness matrix */
+    CSparseMatrix<double>* SparseStiffnessMatrix;
+
 //!	Global nodal force/displacement vector
 	double* Force;
 
+//!	Global nodal force/displacement vectors of a block of at most NRHS load cases
+/*!	The vectors are interleaved: ForceBlock[i*NRHS + k] belongs to equation i+1 in the
+	k-th load case of the block */
+	double* ForceBlock;
+
+public:
+
+//!	Maximum number of load cases in a block solved together by the LDLT solver
+	const static unsigned int NRHS = 64;
+
 private:
 
 //!	Constructor
@@ -83,14 +163,33 @@ private:
 //!	Desconstructor
 	~CDomain();
 
+//!	Call Body(ElementGrp, Nodes, Properties, OldNodes, OldProperties) for every element that differs
+//!	from the element of the same index in Records (see GetElementRecords)
+/*!	Nodes and Properties are nullptr for a removed element, and OldNodes and OldProperties for
+	an added element. Return false if the element groups differ */
+	template <class Function>
+	bool CompareElements(const vector<char>& Records, Function Body);
+
 public:
 
 //!	Return pointer to the instance of the Domain class
 	static CDomain* GetInstance();
 
+//!	Delete the instance of the Domain class, so that the next GetInstance creates a new one
+	static void DeleteInstance();
+
 //!	Read domain data from the input data file
+/*!	Files with the extension .bdat are read as binary input data files */
 	bool ReadData(string FileName, string OutFile);
 
+//!	Read domain data from the binary input data file
+	bool ReadBinaryData(string FileName, string OutFile);
+
+//!	Write the domain data read from an input data file to the binary input data file FileName
+/*!	Must be called before the equations are renumbered. The boundary codes are written
+	as 0 (active) or 1 (fixed) */
+	bool WriteBinaryData(string FileName);
+
 //!	Read nodal point data
 	bool ReadNodalPoints();
 
@@ -100,23 +199,149 @@ public:
 //!	Read element data
 	bool ReadElements();
 
+//!	Store the coordinates of all nodes in Coordinates
+	void StoreCoordinates();
+
 //!	Calculate global equation numbers corresponding to every degree of freedom of each node
 	void CalculateEquationNumber();
 
+//!	Return the FNV-1a hash of the coordinates and equation numbers of the nodes
+	uint64_t CalculateNodeHash();
+
+//!	Return the FNV-1a hash of the coordinates and equation numbers of the nodes, and of the
+//!	elements and material sets of all element groups, which determine the stiffness matrix
+	uint64_t CalculateStructureHash();
+
+//!	Store the elements and material sets of all element groups in the byte array Records
+	void GetElementRecords(vector<char>& Records);
+
+//!	Calculate the update of the stiffness matrix from the elements stored in Records by GetElementRecords
+//!	to the current elements, for the same nodes and equation numbers
+/*!	Equations are the m equations (numbering from 1, in increasing order) touched by the Changed
+	elements that differ. If m does not exceed MaximumRank, Update ([m][m]) is the sum of the
+	differences of their stiffness matrices on these equations, and is empty otherwise. Return
+	false if the element groups differ */
+	bool CalculateStiffnessUpdate(const vector<char>& Records, unsigned int MaximumRank,
+								  vector<unsigned int>& Equations, vector<double>& Update, unsigned int& Changed);
+
+//!	Renumber the equations to reduce the profile of the stiffness matrix
+/*!	Nodes are ordered by the reverse Cuthill-McKee algorithm, and the equations of each node
+	are numbered consecutively in the new node order. The input numbering is kept if the
+	profile is not reduced */
+	void ReorderEquationNumbers();
+
+//!	Calculate the size of the skyline and the maximum half bandwidth for the current equation numbers
+	void CalculateProfile(size_t& NWK, unsigned int& MK);
+
 //!	Calculate column heights
 	void CalculateColumnHeights();
 
+//!	Calculate the sparsity pattern of the sparse stiffness matrix
+	void CalculateSparsity();
+
+//!	Calculate the memory of the arrays of the solution with the solver Type, storing the skyline
+//!	out of core with the memory budget Budget (0 : in core)
+/*!	The column heights (LDLT) or SparseEntries (PCG) must have been calculated. The memory of
+	the PCG solver is an upper bound, which includes an incomplete Cholesky factor */
+	CMemoryEstimate CalculateMemory(SolverTypes Type, size_t Budget);
+
+//!	Renumber the equations, calculate the column heights of the banded stiffness matrix and the
+//!	memory of the solution before the matrices are allocated
+/*!	If the memory limit is exceeded, the skyline is stored out of core with the remaining memory
+	as budget, or else the PCG solver is selected if its memory fits. Return false if the
+	memory limit is exceeded by the solver finally selected */
+	bool EstimateMemory();
+
 //! Allocate storage for matrices
 /*!	Allocate Force, ColumnHeights, DiagonalAddress and StiffnessMatrix and 
-    calculate the column heights and address of diagonal elements */
+    calculate the column heights and address of diagonal elements. The program is
+	stopped if the memory limit is exceeded */
 	void AllocateMatrices();
 
 //!	Assemble the banded gloabl stiffness matrix
-	void AssembleStiffnessMatrix();
+/*!	With FirstColumn > 1, only the columns FirstColumn:NEQ of the banded stiffness matrix are
+	cleared and assembled again from the elements with equations in them, and the columns
+	1:FirstColumn-1 are kept, e.g. as the factors read from a cache file */
+	void AssembleStiffnessMatrix(unsigned int FirstColumn = 1);
+
+//!	Assemble the element stiffness matrix to the global stiffness matrix of the selected solver
+//!	Only the columns FirstColumn:NEQ of the banded stiffness matrix are assembled
+	void AssembleElementStiffness(double* Matrix, unsigned int* LocationMatrix, unsigned int ND,
+								  unsigned int FirstColumn = 1);
+
+//!	Color the elements of a group such that no two elements of the same color share a global equation
+/*!	Elements are returned sorted by color, and the elements of color c are
+	Elements[ColorStart[c]] ... Elements[ColorStart[c+1]-1] in increasing order */
+	void ColorElements(CElementGroup& ElementGrp, vector<unsigned int>& ColorStart, vector<unsigned int>& Elements);
 
 //!	Assemble the global nodal force vector for load case LoadCase
 	bool AssembleForce(unsigned int LoadCase); 
 
+//!	Assemble the global nodal force vectors of load cases FirstLoadCase ... FirstLoadCase+NumberOfCases-1
+//!	into ForceBlock
+	bool AssembleForceBlock(unsigned int FirstLoadCase, unsigned int NumberOfCases);
+
+//!	Copy the displacement of the k-th load case of ForceBlock to the global nodal displacement vector
+	void ExtractDisplacement(unsigned int k, unsigned int NumberOfCases);
+
+//!	Calculate the stresses of all elements for the global nodal displacement vector
+//!	into the stress arrays of the element groups, on all threads
+	void CalculateStresses();
+
+//!	Renumber the equations before allocating the stiffness matrix
+	inline void SetReorder(bool Flag) { Reorder = Flag; }
+
+//!	Return true if the equations are renumbered
+	inline bool GetReorder() { return Reorder; }
+
+//!	Return the size of the skyline for the equation numbers of the input order
+	inline size_t GetNWKInput() { return NWKInput; }
+
+//!	Return the maximum half bandwidth for the equation numbers of the input order
+	inline unsigned int GetMKInput() { return MKInput; }
+
+//!	Store the banded stiffness matrix out of core with a memory budget in bytes (0 : in core)
+	inline void SetMemoryBudget(size_t Budget) { MemoryBudget = Budget; }
+
+//!	Return the memory budget of the out of core skyline solver (0 : in core)
+	inline size_t GetMemoryBudget() { return MemoryBudget; }
+
+//!	Limit the memory of the solution to Limit bytes (0 : no limit)
+	inline void SetMemoryLimit(size_t Limit) { MemoryLimit = Limit; }
+
+//!	Return the memory limit of the solution in bytes (0 : no limit)
+	inline size_t GetMemoryLimit() { return MemoryLimit; }
+
+//!	Stop instead of switching the solver when the memory limit is exceeded
+	inline void SetMemoryAbort(bool Flag) { MemoryAbort = Flag; }
+
+//!	Return the memory of the solution calculated by EstimateMemory
+	inline const CMemoryEstimate& GetMemoryEstimate() { return Memory; }
+
+//!	Return the number of entries of the sparse stiffness matrix counted with duplicates
+	inline size_t GetSparseEntries() { return SparseEntries; }
+
+//!	Return true if the banded stiffness matrix is stored out of core
+	inline bool IsOutOfCore() { return StiffnessMatrix && StiffnessMatrix->IsOutOfCore(); }
+
+//!	Return the size of the input data file in bytes
+	inline size_t GetInputSize() { return InputSize; }
+
+//!	Return the wall clock time spent reading the input data file, without the echo of the data
+	inline double GetParseTime() { return ParseTime; }
+
+//!	Return the wall clock time spent numbering (and renumbering) the equations
+	inline double GetNumberingTime() { return NumberingTime; }
+
+//!	Return the wall clock time spent calculating the column heights and diagonal addresses
+	inline double GetColumnHeightsTime() { return ColumnHeightsTime; }
+
+//!	Set the solver type
+	inline void SetSolverType(SolverTypes Type) { SolverType = Type; }
+
+//!	Return the solver type
+	inline SolverTypes GetSolverType() { return SolverType; }
+
 //!	Return solution mode
 	inline unsigned int GetMODEX() { return MODEX; }
 
@@ -132,6 +357,9 @@ public:
 //!	Return the node list
 	inline CNode* GetNodeList() { return NodeList; }
 
+//!	Return the coordinates of all nodes ([NUMNP][3])
+	inline double* GetCoordinates() { return Coordinates; }
+
 //!	Return total number of element groups
 	inline unsigned int GetNUMEG() { return NUMEG; }
 
@@ -144,6 +372,9 @@ public:
 //!	Return pointer to the global nodal displacement vector
 	inline double* GetDisplacement() { return Force; }
 
+//!	Return pointer to the global nodal force/displacement vectors of a block of load cases
+	inline double* GetForceBlock() { return ForceBlock; }
+
 //!	Return the total number of load cases
 	inline unsigned int GetNLCASE() { return NLCASE; }
 
@@ -156,4 +387,7 @@ public:
 //!	Return pointer to the banded stiffness matrix
 	inline CSkylineMatrix<double>* GetStiffnessMatrix() { return StiffnessMatrix; }
 
+//!	Return pointer to the sparse stiffness matrix
+	inline CSparseMatrix<double>* GetSparseStiffnessMatrix() { return SparseStiffnessMatrix; }
+
 };
@@ -15,7 +15,7 @@
 
 using namespace std;
 
-template <class type> void clear( type* a, unsigned int N );	// Clear an array
+template <class type> void clear( type* a, size_t N );	// Clear an array
 
 //!	Element base class
 /*!	All type of element classes should be derived from this base class */
@@ -26,13 +26,13 @@ protected:
 //!	Number of nodes per element
 	unsigned int NEN_;
 
-//!	Nodes of the element
+//!	Nodes of the element (stored by the element group)
 	CNode** nodes_;
 
-//!	Material of the element
+//!	Material of the element (owned by the element group)
 	CMaterial* ElementMaterial_;	//!< Pointer to an element of MaterialSetList[][]
     
-//! Location Matrix of the element
+//! Location Matrix of the element (stored by the element group)
     unsigned int* LocationMatrix_;
 
 //! Dimension of the location matrix
@@ -41,26 +41,27 @@ protected:
 public:
 
 //!	Constructor
-	CElement() : NEN_(0), nodes_(nullptr), ElementMaterial_(nullptr) {}
+	CElement() : NEN_(0), nodes_(nullptr), ElementMaterial_(nullptr), LocationMatrix_(nullptr) {}
 
 //! Virtual deconstructor
-    virtual ~CElement() {
-        if (nodes_)
-            delete [] nodes_;
-        
-        if (ElementMaterial_)
-            delete [] ElementMaterial_;
-        
-        if (LocationMatrix_)
-            delete [] LocationMatrix_;
-    }
+    virtual ~CElement() {}
 
 //!	Read element data from stream Input
-	virtual bool Read(ifstream& Input, CMaterial* MaterialSets, CNode* NodeList) = 0;
+	virtual bool Read(CTokenizer& Input, CMaterial* MaterialSets, CNode* NodeList) = 0;
 
 //!	Write element data to stream
 	virtual void Write(COutputter& output) = 0;
 
+//!	Connect the element to the nodes NodeNumbers[0:NEN-1] (numbering from 1) of NodeList
+//!	and to its material, as done by Read for the text input data file
+	void Connect(const unsigned int* NodeNumbers, CMaterial* Material, CNode* NodeList)
+	{
+		for (unsigned int N = 0; N < NEN_; N++)
+			nodes_[N] = &NodeList[NodeNumbers[N] - 1];
+
+		ElementMaterial_ = Material;
+	}
+
 //! Generate location matrix: the global equation number that corresponding to each DOF of the element
 //	Caution:  Equation number is numbered from 1 !
     virtual void GenerateLocationMatrix()
@@ -98,6 +99,12 @@ public:
     
     //! Return the Location Matrix of the element
     inline unsigned int* GetLocationMatrix() { return LocationMatrix_; }
+
+    //! Set the storage of the node pointers, which is owned by the element group
+    inline void SetNodes(CNode** Nodes) { nodes_ = Nodes; }
+
+    //! Set the storage of the location matrix, which is owned by the element group
+    inline void SetLocationMatrix(unsigned int* LocationMatrix) { LocationMatrix_ = LocationMatrix; }
     
     //! Return the dimension of the location matrix
     inline unsigned int GetND() { return ND_; }
@@ -16,6 +16,8 @@
 #include "Bar.h"
 #include "Material.h"
 #include "Node.h"
+#include "BinaryDeck.h"
+#include "Tokenizer.h"
 
 using namespace std;
 
@@ -32,13 +34,46 @@ enum ElementTypes
     Shell   // Shell elment
 };
 
+class CElementGroup;
+
+//! Kernels of the element type Type_ on the flat arrays of an element group
+/*! The batch functions of CElementGroup are instantiated for each element type, so the
+    kernels are resolved at compile time instead of by a virtual call per element. The
+    primary template calls the virtual functions of the element objects; element types
+    with kernels on the flat arrays specialize it (see ElementGroup.cpp) */
+template <ElementTypes Type_>
+struct CElementKernel
+{
+    //! Calculate the stiffness matrix of element Ele of Group
+    static void Stiffness(CElementGroup& Group, unsigned int Ele, double* Matrix);
+
+    //! Calculate the stress columns of element Ele of Group
+    static void Stress(CElementGroup& Group, unsigned int Ele, double* Displacement, double* Stress);
+
+    //! Calculate the stiffness matrices of Count elements of Group, one after another in Matrices
+    //! Element(i) returns the index of the i-th element of the batch
+    template <class Index_>
+    static void StiffnessBatch(CElementGroup& Group, Index_ Element, unsigned int Count, double* Matrices);
+
+    //! Calculate the stress columns of elements First ... First+Count-1 of Group, one after another in Stresses
+    static void StressBatch(CElementGroup& Group, unsigned int First, unsigned int Count, double* Displacement,
+                            double* Stresses);
+};
+
 //! Element group class
+/*! The nodes, material sets and location matrices of the elements are also stored in flat
+    arrays, through which the assembly streams without visiting the element objects.
+    The node pointers and location matrices of the element objects point into arrays of
+    the group, so that an element does not allocate memory by itself */
 class CElementGroup
 {
 private:
     //! List of all nodes in the domain, obtained from CDomain object
     static CNode* NodeList_;
 
+    //! Coordinates of all nodes ([NUMNP][3]), obtained from CDomain object
+    static double* Coordinates_;
+
     //! Element type of this group
     ElementTypes ElementType_;
 
@@ -60,7 +95,35 @@ private:
     //! Size of an Material object in this group
     std::size_t MaterialSize_;
 
+    //! Number of nodes, of degrees of freedom and of stress columns per element
+    unsigned int NEN_;
+    unsigned int ND_;
+    unsigned int NCOL_;
+
+    //! Node pointers of all element objects ([NUME][NEN])
+    CNode** NodePointers_;
+
+    //! Node indices (numbered from 0) of all elements ([NUME][NEN])
+    unsigned int* Connectivity_;
+
+    //! Material set indices (numbered from 0) of all elements ([NUME])
+    unsigned int* MaterialSets_;
+
+    //! Location matrices of all elements ([NUME][ND]), shared with the element objects
+    unsigned int* LocationMatrices_;
+
+    //! Stress columns of all elements ([NUME][NCOL]) for the current load case
+    double* Stresses_;
+
+    //! Store the nodes and material sets of the elements, once they are read, in Connectivity_ and MaterialSets_
+    void StoreConnectivity();
+
+    template <ElementTypes Type_> friend struct CElementKernel;
+
 public:
+    //! Number of elements whose stiffness matrices are calculated in one batch by the assembly
+    const static unsigned int BatchSize = 64;
+
     //! Constructor
     CElementGroup();
 
@@ -68,7 +131,13 @@ public:
     ~CElementGroup();
 
     //! Read element group data from stream Input
-    bool Read(ifstream& Input);
+    bool Read(CTokenizer& Input);
+
+    //! Read element group data from the binary input data file Deck
+    bool Read(CBinaryDeck& Deck);
+
+    //! Write element group data to the binary input data file Deck
+    void Write(CBinaryDeck& Deck);
 
     //! Calculate the size of the derived element class and material class
     void CalculateMemberSize();
@@ -94,4 +163,50 @@ public:
 
     //! Return the number of material/section property setss in this element group
     unsigned int GetNUMMAT() { return NUMMAT_; }
+
+    //! Return the number of nodes per element
+    unsigned int GetNEN() { return NEN_; }
+
+    //! Return the dimension of the location matrix of an element
+    unsigned int GetND() { return ND_; }
+
+    //! Return the number of stress columns of an element (e.g. force and stress for bars)
+    unsigned int GetNCOL() { return NCOL_; }
+
+    //! Return the node indices (numbered from 0) of element Ele
+    inline const unsigned int* GetConnectivity(unsigned int Ele) { return Connectivity_ + (std::size_t)Ele * NEN_; }
+
+    //! Return the material set indices (numbered from 0) of all elements ([NUME])
+    inline const unsigned int* GetMaterialSets() { return MaterialSets_; }
+
+    //! Return the location matrix of element Ele
+    inline unsigned int* GetLocationMatrix(unsigned int Ele) { return LocationMatrices_ + (std::size_t)Ele * ND_; }
+
+    //! Return the bytes of the element and material objects and of the flat arrays of the group
+    std::size_t GetMemorySize();
+
+    //! Generate the location matrices of all elements from the equation numbers of their nodes
+    void GenerateLocationMatrices();
+
+    //! Calculate the stiffness matrices of elements First ... First+Count-1 from the flat arrays of the group
+    //! Matrices holds the upper triangular matrices (ND*(ND+1)/2 entries each, column by column) one after another
+    void ComputeStiffnessBatch(unsigned int First, unsigned int Count, double* Matrices);
+
+    //! Calculate the stiffness matrices of elements Elements[0] ... Elements[Count-1]
+    void ComputeStiffnessBatch(const unsigned int* Elements, unsigned int Count, double* Matrices);
+
+    //! Calculate the stiffness matrix of an element of this type with the nodes Nodes (numbered from 0)
+    //! and the material properties Properties, which need not be those of an element of the group
+    void ComputeStiffness(const unsigned int* Nodes, const double* Properties, double* Matrix);
+
+    //! Calculate the stresses of elements First ... First+Count-1 for the global nodal displacement vector
+    //! Displacement. Stresses holds the NCOL stress columns of the elements one after another
+    void ComputeStressBatch(unsigned int First, unsigned int Count, double* Displacement, double* Stresses);
+
+    //! Calculate the stresses of all elements for the global nodal displacement vector Displacement
+    //! into the stress array of the group, on all threads
+    void CalculateStresses(double* Displacement);
+
+    //! Return the stress columns of all elements ([NUME][NCOL]) calculated by CalculateStresses
+    inline const double* GetStresses() { return Stresses_; }
 };
@@ -0,0 +1,95 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#pragma once
+
+#include "SkylineMatrix.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//!	CFactorCache class stores the factorized skyline stiffness matrix in a cache file (.fac)
+/*!	The factorization is reused by a later run whose nodes, equation numbers, elements and
+	material sets, and whose factorization options, give the same key. A run whose nodes,
+	equation numbers and options give the same node key only differs in its elements, and
+	updates the factorization with the element records stored in the file (see
+	CDomain::CalculateStiffnessUpdate). The file is written in the byte order of the machine:
+	- Header : Magic (8 bytes), Version, ByteOrder (uint32), Key, NodeKey (uint64), NEQ (uint32),
+			   padding (uint32), NWK, size of the element records in bytes (uint64)
+	- Element records, padded to a multiple of 8 bytes
+	- Diagonal addresses (uint64 [NEQ+1])
+	- Factorized matrix (double [NWK])
+	The keys are 64-bit FNV-1a hashes, and the diagonal addresses are compared as well, so that
+	a file of another problem is never used */
+class CFactorCache
+{
+private:
+
+//!	Size of the blocks of columns read and written at once, in bytes
+	const static size_t BlockSize = 64 << 20;
+
+//!	Call Body(First, Last) for the blocks of columns First:Last of Matrix (numbering from 1)
+	template <class Function>
+	static void ForEachBlock(CSkylineMatrix<double>& Matrix, Function Body);
+
+public:
+
+//!	Version of the format
+	const static unsigned int Version = 2;
+
+//!	Value of ByteOrder in the byte order of the writing machine
+	const static unsigned int ByteOrder = 0x01020304;
+
+//!	Offset basis of the FNV-1a hash
+	const static uint64_t FNVOffsetBasis = 14695981039346656037ULL;
+
+//!	Return the magic number at the beginning of the file (8 characters, not terminated)
+	static const char* Magic() { return "STAP++LF"; }
+
+//!	Continue the FNV-1a hash Hash with the Size bytes of Data
+	static uint64_t FNV1a(const void* Data, size_t Size, uint64_t Hash = FNVOffsetBasis);
+
+//!	Read the factorized matrix of key Key from the cache file FileName into Matrix, whose diagonal
+//!	addresses are calculated and whose storage is allocated. If NodeKey, Key is compared with the
+//!	node key of the file instead
+//!	Return false, leaving Matrix unchanged, if the file does not exist or belongs to another key
+	static bool Read(const string& FileName, uint64_t Key, CSkylineMatrix<double>& Matrix, bool NodeKey = false);
+
+//!	Read the element records from the cache file FileName if it was written with the node key NodeKey
+	static bool ReadElements(const string& FileName, uint64_t NodeKey, vector<char>& Records);
+
+//!	Write the factorized matrix Matrix with the key Key, the node key NodeKey and the element records
+//!	Records to the cache file FileName
+//!	Return false if the file could not be written completely
+	static bool Write(const string& FileName, uint64_t Key, uint64_t NodeKey, CSkylineMatrix<double>& Matrix,
+					  const vector<char>& Records);
+};
+
+//	Call Body(First, Last) for the blocks of columns First:Last of Matrix
+//	An out of core matrix is released after each block, so that at most one block is kept in memory
+template <class Function>
+void CFactorCache::ForEachBlock(CSkylineMatrix<double>& Matrix, Function Body)
+{
+	size_t* DiagonalAddress = Matrix.GetDiagonalAddress();
+	size_t BlockEntries = BlockSize / sizeof(double);
+
+	unsigned int First = 1;
+	for (unsigned int j = 1; j <= Matrix.dim(); j++)
+		if (j == Matrix.dim() || DiagonalAddress[j + 1] - DiagonalAddress[First - 1] > BlockEntries)
+		{
+			Body(First, j);
+			Matrix.Release(First, j);
+
+			First = j + 1;
+		}
+}
@@ -0,0 +1,84 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#pragma once
+
+//!	Define set of instruction sets of the vector kernels
+enum SIMDLevels
+{
+    ScalarKernels = 0,  // Portable C++ loops
+    AVX2Kernels,        // 256-bit AVX2 and FMA instructions
+    AVX512Kernels       // 512-bit AVX-512F instructions
+};
+
+//!	CKernels class provides the inner loops of the skyline solver on contiguous arrays
+/*!	The kernels are implemented for each instruction set, and the fastest one supported
+	by the processor is selected at run time. The scalar dot products sum from the last
+	element to the first, i.e. in the order of increasing equation numbers for the columns
+	of the skyline. The vectorized dot products sum in a different order and may differ in
+	the last bits, while the vectorized axpy kernels give the same results as the scalar ones.
+	The bar stiffness and stress kernels evaluate one bar per vector lane with the operations of
+	CBar::Stiffness and CBar::Stress in the same order, so their results are identical */
+class CKernels
+{
+private:
+
+//!	Instruction set of the selected kernels
+	static SIMDLevels Level_;
+
+//!	Selected kernels
+	static double (*Dot_)(const double* a, const double* b, unsigned int n);
+	static double (*DotReverse_)(const double* a, const double* b, unsigned int n);
+	static void (*Axpy_)(double* y, double alpha, const double* x, unsigned int n);
+	static void (*AxpyReverse_)(double* y, double alpha, const double* x, unsigned int n);
+	static void (*BarStiffness_)(const double* DX, const double* DY, const double* DZ, const double* EA,
+								 unsigned int n, double* Matrices);
+	static void (*BarStress_)(const double* DX, const double* DY, const double* DZ, const double* E,
+							  const double* U, unsigned int n, double* Stress);
+
+public:
+
+//!	Return the fastest instruction set supported by the processor and the compiler
+	static SIMDLevels GetSupportedLevel();
+
+//!	Select the kernels of the instruction set Level, or of the fastest supported one
+//!	if Level is not supported. Return the selected instruction set
+	static SIMDLevels SetLevel(SIMDLevels Level);
+
+//!	Return the instruction set of the selected kernels
+	static SIMDLevels GetLevel() { return Level_; }
+
+//!	Return the name of an instruction set
+	static const char* GetLevelName(SIMDLevels Level);
+
+//!	Return sum(a[k]*b[k], k=0:n-1)
+	static double Dot(const double* a, const double* b, unsigned int n) { return Dot_(a, b, n); }
+
+//!	Return sum(a[k]*b[n-1-k], k=0:n-1)
+	static double DotReverse(const double* a, const double* b, unsigned int n) { return DotReverse_(a, b, n); }
+
+//!	y[k] += alpha*x[k], k=0:n-1
+	static void Axpy(double* y, double alpha, const double* x, unsigned int n) { Axpy_(y, alpha, x, n); }
+
+//!	y[k] += alpha*x[n-1-k], k=0:n-1
+	static void AxpyReverse(double* y, double alpha, const double* x, unsigned int n) { AxpyReverse_(y, alpha, x, n); }
+
+//!	Calculate the stiffness matrices of n bars, as CBar::Stiffness, from the differences DX, DY, DZ of the
+//!	coordinates of their nodes and the products EA of their Young's modulus and area.
+//!	Matrices[21*i:21*i+20] receives the upper triangular matrix of the i-th bar
+	static void BarStiffness(const double* DX, const double* DY, const double* DZ, const double* EA,
+							 unsigned int n, double* Matrices) { BarStiffness_(DX, DY, DZ, EA, n, Matrices); }
+
+//!	Calculate the stresses of n bars, as CBar::Stress, from the differences DX, DY, DZ of the coordinates
+//!	of their nodes, their Young's modulus E and the displacements U[j*n+i] of their degrees of freedom
+//!	j = 0:5 (0 for fixed degrees of freedom)
+	static void BarStress(const double* DX, const double* DY, const double* DZ, const double* E,
+						  const double* U, unsigned int n, double* Stress) { BarStress_(DX, DY, DZ, E, U, n, Stress); }
+};
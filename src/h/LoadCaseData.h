@@ -11,6 +11,7 @@
 #pragma once
 
 #include "Outputter.h"
+#include "Tokenizer.h"
 
 using namespace std;
 
@@ -33,7 +34,7 @@ public:
 	void Allocate(unsigned int num);
 
 //!	Read load case data from stream Input
-	bool Read(ifstream& Input);
+	bool Read(CTokenizer& Input);
 
 //!	Write load case data to stream
 	void Write(COutputter& output);
@@ -0,0 +1,71 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+//!	CMappedFile class maps a file into memory
+/*!	A scratch file created by Create is removed as soon as it is mapped, so that it disappears
+	with the program. Its pages are read and written back by the operating system on demand,
+	and the resident part can be controlled with Prefetch and Release. An existing file is
+	mapped read-only by Open. Memory-mapped files are only supported on POSIX systems;
+	elsewhere Create always fails and Open reads the whole file into memory */
+class CMappedFile
+{
+private:
+
+//!	Address of the mapping
+	char* data_;
+
+//!	Size of the mapping in bytes
+	size_t size_;
+
+//!	Copy of the file when it cannot be mapped
+	char* Buffer_;
+
+//!	File descriptor of the scratch file
+	int File_;
+
+public:
+
+//!	Constructor
+	CMappedFile() : data_(nullptr), size_(0), Buffer_(nullptr), File_(-1) {};
+
+//!	Desconstructor
+	~CMappedFile();
+
+//!	Create a zero-filled scratch file of Size bytes in Directory and map it into memory
+//!	Return false if the file cannot be created or mapped
+	bool Create(const string& Directory, size_t Size);
+
+//!	Map the existing file FileName into memory for reading
+//!	Return false if the file cannot be opened
+	bool Open(const string& FileName);
+
+//!	Return the address of the mapping
+	inline char* data() { return data_; }
+
+//!	Return the size of the mapping in bytes
+	inline size_t size() const { return size_; }
+
+//!	Return the size of the memory pages
+	static size_t PageSize();
+
+//!	Start reading the bytes [Offset, Offset+Length) asynchronously
+	void Prefetch(size_t Offset, size_t Length);
+
+//!	Remove the pages contained in [Offset, Offset+Length) from memory
+/*!	Modified pages are written back to the file, so that their data is kept */
+	void Release(size_t Offset, size_t Length);
+};
@@ -11,6 +11,7 @@
 #pragma once
 
 #include "Outputter.h"
+#include "Tokenizer.h"
 
 using namespace std;
 
@@ -30,11 +31,20 @@ public:
     virtual ~CMaterial() {};
 
 //!	Read material data from stream Input
-	virtual bool Read(ifstream& Input) = 0;
+	virtual bool Read(CTokenizer& Input) = 0;
 
 //!	Write material data to Stream
     virtual void Write(COutputter& output) = 0;
 
+//!	Return the number of material properties stored in binary input data files
+	virtual unsigned int GetNumberOfProperties() { return 1; }
+
+//!	Copy the material properties to Properties[0:GetNumberOfProperties()-1]
+	virtual void GetProperties(double* Properties) { Properties[0] = E; }
+
+//!	Set the material properties from Properties[0:GetNumberOfProperties()-1]
+	virtual void SetProperties(const double* Properties) { E = Properties[0]; }
+
 };
 
 //!	Material class for bar element
@@ -47,8 +57,17 @@ public:
 public:
 	
 //!	Read material data from stream Input
-	virtual bool Read(ifstream& Input);
+	virtual bool Read(CTokenizer& Input);
 
 //!	Write material data to Stream
 	virtual void Write(COutputter& output);
+
+//!	Return the number of material properties stored in binary input data files (E and Area)
+	virtual unsigned int GetNumberOfProperties() { return 2; }
+
+//!	Copy the material properties E and Area to Properties
+	virtual void GetProperties(double* Properties);
+
+//!	Set the material properties E and Area from Properties
+	virtual void SetProperties(const double* Properties);
 };
@@ -11,6 +11,7 @@
 #pragma once
 
 #include "Outputter.h"
+#include "Tokenizer.h"
 
 using namespace std;
 
@@ -40,7 +41,7 @@ public:
 	CNode(double X = 0, double Y = 0, double Z = 0);
 
 //!	Read nodal point data from stream Input
-	bool Read(ifstream& Input);
+	bool Read(CTokenizer& Input);
 
 //!	Output nodal point data to stream
 	void Write(COutputter& output);
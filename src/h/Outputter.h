@@ -13,10 +13,22 @@
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "ResultsFile.h"
 
 using namespace std;
 
 //! Outputer class is used to output results
+/*!	The output is formatted into a memory buffer, without flushing at the end of the lines.
+	Full blocks of the buffer are passed to a background thread, which writes them to the
+	output file and echoes them to the console, while the solution goes on. The remaining
+	output is written by Flush, which is also called at the exit of the program */
 class COutputter
 {
 private:
@@ -27,9 +39,54 @@ private:
 //!	Designed as a single instance class
 	static COutputter* _instance;
 
+//!	Echo the output to the console
+	static bool Console_;
+
+//!	Size of the blocks passed to the writer thread in bytes
+	const static size_t BlockSize = 1 << 22;
+
+//!	Maximum number of blocks waiting for the writer thread
+	const static size_t MaximumBlocks = 4;
+
+//!	Formatted output not yet passed to the writer thread
+	ostringstream Buffer_;
+
+//!	Blocks waiting for the writer thread, the first one is being written
+	deque<string> Blocks_;
+
+//!	Lock of Blocks_ and Done_
+	mutex Mutex_;
+
+//!	Signaled when a block is queued or written
+	condition_variable Signal_;
+
+//!	Set to stop the writer thread
+	bool Done_;
+
+//!	Writer thread
+	thread Writer_;
+
+//!	Binary results file (nullptr : none)
+	CResultsFile* Results_;
+
+//!	Write the displacements and stresses to the output file
+	bool TextResults_;
+
+//!	Number of load cases written to the binary results file
+	unsigned int LoadCase_;
+
 //! Constructor
     COutputter(string FileName);
 
+//!	Write the queued blocks until Done_ is set (run by the writer thread)
+	void Write();
+
+//!	Pass the buffer to the writer thread, waiting if too many blocks are queued
+	void Submit();
+
+//!	Write the remaining output and stop the writer thread (called at exit)
+	static void Finish();
+
 public:
 
 //!	Return pointer to the output file stream
@@ -38,6 +95,23 @@ public:
 //!	Return the single instance of the class
 	static COutputter* GetInstance(string FileName = " ");
 
+//!	Write the remaining output, stop the writer thread and close the output file, so that the
+//!	next GetInstance opens the output file again
+	static void DeleteInstance();
+
+//!	Echo the output to the console or not (default true)
+	static void SetConsole(bool Console) { Console_ = Console; }
+
+//!	Write all output passed so far to the output file and the console
+	void Flush();
+
+//!	Write the displacements and stresses of all load cases to the binary results file FileName,
+//!	and also to the output file if Text is true. Return false if the file cannot be created
+	bool OpenResults(const string& FileName, bool Text);
+
+//!	Close the binary results file, return false if it could not be written completely
+	bool CloseResults();
+
 //!	Output current time and date
 	void PrintTime(const struct tm * ptm, COutputter& output);
 
@@ -62,26 +136,32 @@ public:
 //!	Output displacement data
 	void OutputNodalDisplacement();
 
-//!	Output element stresses 
+//!	Output element stresses calculated by CDomain::CalculateStresses
 	void OutputElementStress();
 
 //!	Print total system data
 	void OutputTotalSystemData();
 
+//!	Print the memory of the solution calculated by CDomain::EstimateMemory
+	void OutputMemoryEstimate();
+
 //! Overload the operator <<
 	template <typename T>
 	COutputter& operator<<(const T& item) 
 	{
-		std::cout << item;
-		OutputFile << item;
+		Buffer_ << item;
 		return *this;
 	}
 
+//!	The buffer is passed to the writer thread at the end of a line when a block is full
 	typedef std::basic_ostream<char, std::char_traits<char> > CharOstream;
 	COutputter& operator<<(CharOstream& (*op)(CharOstream&)) 
 	{
-		op(std::cout);
-		op(OutputFile);
+		op(Buffer_);
+
+		if ((size_t)Buffer_.tellp() >= BlockSize)
+			Submit();
+
 		return *this;
 	}
 
@@ -0,0 +1,81 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#pragma once
+
+#include "Profiler.h"
+
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//!	CParallel class is used to run loops of the solution phases on several threads
+/*!	The number of threads is shared by all parallel stages. With a single thread,
+	every stage runs its original serial code */
+class CParallel
+{
+private:
+
+//!	Number of threads used by the parallel stages
+	static unsigned int NumberOfThreads_;
+
+public:
+
+//!	Set the number of threads (0 : use all hardware threads)
+	static void SetNumberOfThreads(unsigned int N);
+
+//!	Return the number of threads
+	static unsigned int GetNumberOfThreads() { return NumberOfThreads_; }
+
+//!	Split [First, Last) into one contiguous chunk per thread and call Body(Begin, End, Thread)
+//!	for each chunk. Chunk 0 runs on the calling thread.
+	template <class Function>
+	static void For(unsigned int First, unsigned int Last, Function Body);
+};
+
+//	Split [First, Last) into one contiguous chunk per thread
+template <class Function>
+void CParallel::For(unsigned int First, unsigned int Last, Function Body)
+{
+	if (Last <= First)
+		return;
+
+	unsigned int N = Last - First;
+	unsigned int NT = NumberOfThreads_ < N ? NumberOfThreads_ : N;
+
+	if (NT <= 1)
+	{
+		Body(First, Last, 0u);
+		return;
+	}
+
+	vector<thread> Workers;
+	Workers.reserve(NT - 1);
+
+//	The chunks of the worker threads are timed as phases of the threads 1 ... NT-1
+	auto Chunk = [&Body](unsigned int Begin, unsigned int End, unsigned int t)
+	{
+		CProfileScope Scope("CParallel::For", t);
+		Body(Begin, End, t);
+	};
+
+	for (unsigned int t = 1; t < NT; t++)
+	{
+		unsigned int Begin = First + (unsigned int)((unsigned long long)N * t / NT);
+		unsigned int End = First + (unsigned int)((unsigned long long)N * (t + 1) / NT);
+		Workers.push_back(thread(Chunk, Begin, End, t));
+	}
+
+	Body(First, First + N / NT, 0u);
+
+	for (unsigned int t = 0; t < Workers.size(); t++)
+		Workers[t].join();
+}
@@ -0,0 +1,109 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+using namespace std;
+
+//!	CProfiler class records the phases of the solution timed by CProfileScope objects
+/*!	Each phase records its wall clock time, the CPU time of the process (all threads), the
+	high-water mark of the resident memory at its end, and, where perf_event is available, the
+	cycles and instructions of its thread. Phases nest as the scopes that time them. Phases are
+	only recorded once the profiler is enabled, and are written as a Chrome trace
+	(chrome://tracing or Perfetto) by WriteTrace */
+class CProfiler
+{
+public:
+
+//!	A timed phase
+	struct CPhase
+	{
+		const char* Name;		// Name of the phase (a string literal)
+		unsigned int Thread;	// Thread of the phase (0 : main thread, t : chunk t of CParallel::For)
+		unsigned int Depth;		// Number of enclosing phases on the same thread
+		double Start;			// Wall clock time at the beginning, in seconds since the start of the program
+		double Wall;			// Wall clock time in seconds
+		double CPU;				// CPU time of the process in seconds
+		long MaxRSS;			// High-water mark of the resident memory at the end, in kilobytes (-1 : unknown)
+		long long Cycles;		// Cycles of the thread (-1 : no hardware counters)
+		long long Instructions;	// Instructions of the thread (-1 : no hardware counters)
+	};
+
+private:
+
+//!	Phases completed so far, in the order of their ends
+	static vector<CPhase> Phases_;
+
+//!	Protects Phases_ from phases ending on several threads
+	static mutex Mutex_;
+
+//!	Record the phases, with the hardware counters
+	static bool Enabled_;
+
+public:
+
+//!	Record the phases timed from now on, reading the cycles and instructions from the hardware counters
+	static void Enable(bool Flag) { Enabled_ = Flag; }
+
+//!	Return true if the phases are recorded
+	static bool IsEnabled() { return Enabled_; }
+
+//!	Return the wall clock time in seconds since the start of the program
+	static double WallTime();
+
+//!	Return the CPU time of the process (all threads) in seconds
+	static double CPUTime();
+
+//!	Return the high-water mark of the resident memory in kilobytes (-1 : unknown)
+	static long MaxRSS();
+
+//!	Read the cycles and instructions of the calling thread into Values
+/*!	Return false if the profiler is not enabled or the hardware counters are not available */
+	static bool ReadCounters(long long Values[2]);
+
+//!	Record a completed phase
+	static void Record(const CPhase& Phase);
+
+//!	Write the phases to FileName in the Chrome trace event format
+/*!	Return false if the file cannot be written */
+	static bool WriteTrace(const string& FileName);
+};
+
+//!	CProfileScope class times a phase from its construction to its destruction
+/*!	Name must remain valid until the trace is written, e.g. a string literal. Nothing is timed
+	unless the profiler is enabled */
+class CProfileScope
+{
+private:
+
+//!	The phase timed
+	CProfiler::CPhase Phase_;
+
+//!	Hardware counters at the beginning of the phase
+	long long Counters_[2];
+
+//!	The phase is recorded, i.e. the profiler was enabled at its beginning
+	bool Active_;
+
+//!	The hardware counters were read at the beginning of the phase
+	bool Counted_;
+
+public:
+
+//!	Begin the phase Name on the thread Thread (0 : main thread, t : chunk t of CParallel::For)
+	CProfileScope(const char* Name, unsigned int Thread = 0);
+
+//!	End the phase and record it
+	~CProfileScope();
+};
@@ -0,0 +1,145 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//!	CResultsFile class writes and reads the binary results file (.bres)
+/*!	The results file holds the nodal displacements and element stresses of all load cases in
+	the byte order of the machine that wrote it. Every array starts at a multiple of 8 bytes.
+	- Header : Magic (8 bytes), Version, ByteOrder (uint32), Title (256 bytes),
+			   NUMNP, NDF, NUMEG, NLCASE (uint32)
+	- Element groups : ElementType, NUME, NCOL (uint32 [NUMEG][3])
+	- For each load case : LoadCase (uint32), displacements (double [NUMNP][NDF]),
+			   and for each element group the stresses (double [NUME][NCOL])
+	All load cases have the same size, so that each one is found without reading the others.
+	The columns of the stresses are those of the output file, e.g. force and stress for bars */
+class CResultsFile
+{
+private:
+
+//!	Output stream of the file being written
+	ofstream Output_;
+
+//!	Mapping of the file being read
+	CMappedFile File_;
+
+//!	Title of the problem
+	string Title_;
+
+//!	Number of nodal points, degrees of freedom per node, element groups and load cases
+	unsigned int NUMNP_;
+	unsigned int NDF_;
+	unsigned int NUMEG_;
+	unsigned int NLCASE_;
+
+//!	ElementType, NUME and NCOL of each element group
+	vector<unsigned int> Groups_;
+
+//!	Number of complete load cases in the file being read
+	unsigned int NumberOfLoadCases_;
+
+//!	Offset of the first load case, and size of a load case in bytes
+	size_t FirstLoadCase_;
+	size_t LoadCaseSize_;
+
+//!	Write Count values of type T_, padded to a multiple of 8 bytes
+	template <class T_>
+	void Write(const T_* Data, size_t Count);
+
+//!	Calculate the offsets of the load cases
+	void CalculateOffsets();
+
+public:
+
+//!	Version of the format
+	const static unsigned int Version = 1;
+
+//!	Value of ByteOrder in the byte order of the writing machine
+	const static unsigned int ByteOrder = 0x01020304;
+
+//!	Return the magic number at the beginning of the file (8 characters, not terminated)
+	static const char* Magic() { return "STAP++BR"; }
+
+//!	Constructor
+	CResultsFile() : NUMNP_(0), NDF_(0), NUMEG_(0), NLCASE_(0), NumberOfLoadCases_(0),
+					 FirstLoadCase_(0), LoadCaseSize_(0) {};
+
+//!	Create the results file FileName and write its header
+//!	Groups holds ElementType, NUME and NCOL of each element group
+	bool Create(const string& FileName, const string& Title, unsigned int NUMNP, unsigned int NDF,
+				unsigned int NLCASE, const vector<unsigned int>& Groups);
+
+//!	Start load case LoadCase (numbered from 1) with its nodal displacements (double [NUMNP][NDF])
+	void WriteDisplacements(unsigned int LoadCase, const double* Displacements);
+
+//!	Write the stresses of the next element group (double [NUME][NCOL])
+	void WriteStresses(const double* Stresses, size_t Count);
+
+//!	Close the file being written, return false if it could not be written completely
+	bool Close();
+
+//!	Open the results file FileName for reading
+//!	Return false if it is not a results file of this machine
+	bool Open(const string& FileName);
+
+//!	Return the title of the problem
+	inline const string& GetTitle() const { return Title_; }
+
+//!	Return the number of nodal points
+	inline unsigned int GetNUMNP() const { return NUMNP_; }
+
+//!	Return the number of degrees of freedom per node
+	inline unsigned int GetNDF() const { return NDF_; }
+
+//!	Return the number of element groups
+	inline unsigned int GetNUMEG() const { return NUMEG_; }
+
+//!	Return the number of load cases of the problem
+	inline unsigned int GetNLCASE() const { return NLCASE_; }
+
+//!	Return the number of load cases stored completely in the file being read
+	inline unsigned int GetNumberOfLoadCases() const { return NumberOfLoadCases_; }
+
+//!	Return the element type of element group EleGrp
+	inline unsigned int GetElementType(unsigned int EleGrp) const { return Groups_[3 * EleGrp]; }
+
+//!	Return the number of elements of element group EleGrp
+	inline unsigned int GetNUME(unsigned int EleGrp) const { return Groups_[3 * EleGrp + 1]; }
+
+//!	Return the number of stress columns of element group EleGrp
+	inline unsigned int GetNCOL(unsigned int EleGrp) const { return Groups_[3 * EleGrp + 2]; }
+
+//!	Return the load case number of the lcase-th load case in the file (from 0)
+	unsigned int GetLoadCase(unsigned int lcase);
+
+//!	Return the nodal displacements of the lcase-th load case in the file (from 0)
+	const double* GetDisplacements(unsigned int lcase);
+
+//!	Return the stresses of element group EleGrp of the lcase-th load case in the file (from 0)
+	const double* GetStresses(unsigned int lcase, unsigned int EleGrp);
+};
+
+//	Write Count values of type T_, padded to a multiple of 8 bytes
+template <class T_>
+void CResultsFile::Write(const T_* Data, size_t Count)
+{
+	const char Padding[8] = {0};
+
+	Output_.write((const char*)Data, Count * sizeof(T_));
+	Output_.write(Padding, (8 - Count * sizeof(T_) % 8) % 8);
+}
@@ -12,12 +12,21 @@
 
 #include <string>
 #include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <algorithm>
+
+#include "MappedFile.h"
 
 #ifdef _DEBUG_
 #include "Outputter.h"
 #endif
 
 //! CSkylineMatrix class is used to store the FEM stiffness matrix in skyline storage
+/*! The storage size and the diagonal addresses are 64-bit (size_t), so that skylines with more
+    than 4 billion entries can be stored. Equation numbers and column heights remain unsigned int */
 template <class T_>
 class CSkylineMatrix
 {
@@ -33,13 +42,16 @@ private:
     unsigned int MK_;
 
 //! Size of the storage used to store the stiffness matrkix in skyline
-    unsigned int NWK_;
+    size_t NWK_;
 
 //! Column hights
     unsigned int* ColumnHeights_;
     
 //! Diagonal address of all columns in data_
-    unsigned int* DiagonalAddress_;
+    size_t* DiagonalAddress_;
+
+//! Scratch file holding data_ when the matrix is stored out of core (nullptr when in core)
+    CMappedFile* File_;
     
 public:
 
@@ -57,11 +69,24 @@ public:
 #ifdef _DEBUG_
 //! operator (i) where i numbering from 1
 //! For the sake of efficiency, the index bounds are not checked
-    inline T_& operator()(unsigned int i);
+    inline T_& operator()(size_t i);
 #endif
     
 //! Allocate storage for the skyline matrix
     inline void Allocate();
+
+//! Allocate storage for the skyline matrix in a memory-mapped scratch file in Directory
+//! Return false if the file cannot be created, in which case nothing is allocated
+    inline bool AllocateOutOfCore(const std::string& Directory);
+
+//! Return true if the matrix is stored in a scratch file
+    inline bool IsOutOfCore() const { return File_ != nullptr; }
+
+//! Start reading the columns First:Last (numbering from 1) of an out of core matrix
+    inline void Prefetch(unsigned int First, unsigned int Last);
+
+//! Remove the columns First:Last (numbering from 1) of an out of core matrix from memory
+    inline void Release(unsigned int First, unsigned int Last);
     
 //! Calculate the column height, used with the skyline storage scheme
     void CalculateColumnHeight(unsigned int* LocationMatrix, size_t ND);
@@ -71,10 +96,20 @@ public:
 
 //! Calculate address of diagonal elements in banded matrix
 //! Caution: Address is numbered from 1 !
+//! The program is stopped if the size of the skyline cannot be addressed
     void CalculateDiagnoalAddress();
 
 //! Assemble the element stiffness matrix to the global stiffness matrix
-    void Assembly(double* Matrix, unsigned int* LocationMatrix, size_t ND);
+//! Only the entries in the columns FirstColumn:NEQ are assembled
+    void Assembly(double* Matrix, unsigned int* LocationMatrix, size_t ND, unsigned int FirstColumn = 1);
+
+//! Set the columns First:Last (numbering from 1) to zero
+    inline void Clear(unsigned int First, unsigned int Last);
+
+//! Return pointer to the skyline storage data_
+//! Column j (numbering from 1) is stored from its diagonal element upward, i.e.
+//! K(r,j) = data()[DiagonalAddress_[j-1] - 1 + (j - r)]
+    inline T_* data();
 
 //! Return pointer to the ColumnHeights_
     inline unsigned int* GetColumnHeights();
@@ -83,13 +118,13 @@ public:
     inline unsigned int GetMaximumHalfBandwidth() const;
 
 //! Return pointer to the DiagonalAddress_
-    inline unsigned int* GetDiagonalAddress();
+    inline size_t* GetDiagonalAddress();
 
 //! Return the dimension of the stiffness matrix
     inline unsigned int dim() const;
     
 //! Return the size of the storage used to store the stiffness matrkix in skyline
-    inline unsigned int size() const;
+    inline size_t size() const;
 
 }; /* class definition */
 
@@ -104,6 +139,7 @@ inline CSkylineMatrix<T_>::CSkylineMatrix()
     data_ = nullptr;
     ColumnHeights_ = nullptr;
     DiagonalAddress_ = nullptr;
+    File_ = nullptr;
 }
 
 template <class T_>
@@ -114,12 +150,13 @@ inline CSkylineMatrix<T_>::CSkylineMatrix(unsigned int N)
     NWK_ = 0;
 
     data_ = nullptr;
+    File_ = nullptr;
     
     ColumnHeights_ = new unsigned int [NEQ_];
     for (unsigned int i = 0; i < NEQ_; i++)
         ColumnHeights_[i] = 0;
 
-    DiagonalAddress_ = new unsigned int [NEQ_ + 1];
+    DiagonalAddress_ = new size_t [NEQ_ + 1];
     for (unsigned int i = 0; i < NEQ_ + 1; i++)
         DiagonalAddress_[i] = 0;
 }
@@ -134,7 +171,9 @@ inline CSkylineMatrix<T_>::~CSkylineMatrix<T_>()
     if (DiagonalAddress_)
         delete[] DiagonalAddress_;
     
-    if (data_)
+    if (File_)
+        delete File_;
+    else if (data_)
         delete[] data_;
 }
 
@@ -151,7 +190,7 @@ inline T_& CSkylineMatrix<T_>::operator()(unsigned int i, unsigned int j)
 #ifdef _DEBUG_
 //! operator function (i) where i numbering from 1
 template <class T_>
-inline T_& CSkylineMatrix<T_>::operator()(unsigned int i)
+inline T_& CSkylineMatrix<T_>::operator()(size_t i)
 {
     return data_[i];
 }
@@ -163,11 +202,73 @@ inline void CSkylineMatrix<T_>::Allocate()
 {
     NWK_ = DiagonalAddress_[NEQ_] - DiagonalAddress_[0];
 
-    data_ = new T_[NWK_];
-    for (unsigned int i = 0; i < NWK_; i++)
+    data_ = new (std::nothrow) T_[NWK_];
+    if (!data_)
+    {
+        std::cerr << "*** Error *** Not enough memory for the stiffness matrix !" << std::endl
+                  << "    NWK = " << NWK_ << " (" << NWK_ * sizeof(T_) / 1048576 << " MB)" << std::endl;
+
+        exit(6);
+    }
+
+    for (size_t i = 0; i < NWK_; i++)
         data_[i] = T_(0);
 }
 
+//! Allocate storage for the matrix in a memory-mapped scratch file
+//! The file is created empty, so that the zero entries are neither written nor kept in memory
+template <class T_>
+inline bool CSkylineMatrix<T_>::AllocateOutOfCore(const std::string& Directory)
+{
+    NWK_ = DiagonalAddress_[NEQ_] - DiagonalAddress_[0];
+
+    File_ = new CMappedFile;
+    if (!File_->Create(Directory, NWK_ * sizeof(T_)))
+    {
+        delete File_;
+        File_ = nullptr;
+
+        return false;
+    }
+
+    data_ = (T_*)File_->data();
+
+    return true;
+}
+
+//! Start reading the columns First:Last of an out of core matrix
+template <class T_>
+inline void CSkylineMatrix<T_>::Prefetch(unsigned int First, unsigned int Last)
+{
+    if (File_ && First <= Last)
+        File_->Prefetch((DiagonalAddress_[First-1] - 1) * sizeof(T_),
+                        (DiagonalAddress_[Last] - DiagonalAddress_[First-1]) * sizeof(T_));
+}
+
+//! Remove the columns First:Last of an out of core matrix from memory
+template <class T_>
+inline void CSkylineMatrix<T_>::Release(unsigned int First, unsigned int Last)
+{
+    if (File_ && First <= Last)
+        File_->Release((DiagonalAddress_[First-1] - 1) * sizeof(T_),
+                       (DiagonalAddress_[Last] - DiagonalAddress_[First-1]) * sizeof(T_));
+}
+
+//! Set the columns First:Last to zero
+template <class T_>
+inline void CSkylineMatrix<T_>::Clear(unsigned int First, unsigned int Last)
+{
+    if (First <= Last)
+        std::fill(data_ + DiagonalAddress_[First-1] - 1, data_ + DiagonalAddress_[Last] - 1, T_(0));
+}
+
+//! Return pointer to the skyline storage data_
+template <class T_>
+inline T_* CSkylineMatrix<T_>::data()
+{
+    return data_;
+}
+
 //! Return pointer to the ColumnHeights_
 template <class T_>
 inline unsigned int* CSkylineMatrix<T_>::GetColumnHeights()
@@ -184,7 +285,7 @@ inline unsigned int CSkylineMatrix<T_>::GetMaximumHalfBandwidth() const
 
 //! Return pointer to the DiagonalAddress_
 template <class T_>
-inline unsigned int* CSkylineMatrix<T_>::GetDiagonalAddress()
+inline size_t* CSkylineMatrix<T_>::GetDiagonalAddress()
 {
     return DiagonalAddress_;
 }
@@ -198,7 +299,7 @@ inline unsigned int CSkylineMatrix<T_>::dim() const
 
 //! Return the size of the storage used to store the stiffness matrkix in skyline
 template <class T_>
-inline unsigned int CSkylineMatrix<T_>::size() const
+inline size_t CSkylineMatrix<T_>::size() const
 {
    return(NWK_);
 }
@@ -240,7 +341,7 @@ void CSkylineMatrix<T_>::CalculateMaximumHalfBandwidth()
 
 //    Assemble the banded global stiffness matrix (skyline storage scheme)
 template <class T_>
-void CSkylineMatrix<T_>::Assembly(double* Matrix, unsigned int* LocationMatrix, size_t ND)
+void CSkylineMatrix<T_>::Assembly(double* Matrix, unsigned int* LocationMatrix, size_t ND, unsigned int FirstColumn)
 {
 //  Assemble global stiffness matrix
     for (unsigned int j = 0; j < ND; j++)
@@ -255,7 +356,7 @@ void CSkylineMatrix<T_>::Assembly(double* Matrix, unsigned int* LocationMatrix,
         {
             unsigned int Li = LocationMatrix[i];    // Global equation number corresponding to ith DOF of the element
             
-            if (!Li) continue;
+            if (!Li || std::max(Li, Lj) < FirstColumn) continue;
             
             (*this)(Li,Lj) += Matrix[DiagjElement + j - i];
         }
@@ -271,9 +372,27 @@ void CSkylineMatrix<T_>::CalculateDiagnoalAddress()
 {
     //    Calculate the address of diagonal elements
     //    M(0) = 1;  M(i+1) = M(i) + H(i) + 1 (i = 0:NEQ)
+    //    The addresses are limited such that the size of data_ in bytes fits in size_t
+    const size_t MaxAddress = SIZE_MAX / sizeof(T_);
+
     DiagonalAddress_[0] = 1;
     for (unsigned int col = 1; col <= NEQ_; col++)
-        DiagonalAddress_[col] = DiagonalAddress_[col - 1] + ColumnHeights_[col-1] + 1;
+    {
+        size_t Height = (size_t)ColumnHeights_[col-1] + 1;
+
+        if (Height > MaxAddress - DiagonalAddress_[col - 1])
+        {
+            std::cerr << "*** Error *** The skyline of the stiffness matrix is too large to be addressed !" << std::endl
+                      << "    Euqation no = " << col << std::endl;
+
+            exit(6);
+        }
+
+        DiagonalAddress_[col] = DiagonalAddress_[col - 1] + Height;
+    }
+
+    //    The size is known before the storage is allocated, e.g. for the memory estimate
+    NWK_ = DiagonalAddress_[NEQ_] - DiagonalAddress_[0];
     
 #ifdef _DEBUG_
     COutputter* Output = COutputter::GetInstance();
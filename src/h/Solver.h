@@ -11,22 +11,198 @@
 #pragma once
 
 #include "SkylineMatrix.h"
+#include "SparseMatrix.h"
 
-//!	LDLT solver: A in core solver using skyline storage  and column reduction scheme
+#include <vector>
+
+using namespace std;
+
+//!	Define set of solvers for the linear equilibrium equations
+enum SolverTypes
+{
+    SkylineLDLT = 0,    // Direct LDLT solver with skyline storage
+    SparsePCG           // Preconditioned conjugate gradient solver with compressed sparse row storage
+};
+
+//!	Define set of preconditioners of the PCG solver
+enum Preconditioners
+{
+    JacobiPreconditioner = 0,       // Diagonal scaling
+    IncompleteCholesky              // Incomplete Cholesky factorization without fill-in, IC(0)
+};
+
+//!	Define set of factorization schemes of the LDLT solver
+enum LDLTSchemes
+{
+    ColumnReduction = 0,    // Active column reduction, one column at a time
+    BlockedReduction,       // Panels of adjacent columns updated together
+    ParallelReduction       // Columns reduced concurrently on all threads
+};
+
+//!	LDLT solver: A direct solver using skyline storage  and column reduction scheme
+/*!	The skyline is either held in memory or, for an out of core matrix, streamed from a
+	memory-mapped scratch file through a window bounded by the memory budget */
 class CLDLTSolver
 {
 private:
-    
+
     CSkylineMatrix<double>& K;
 
+//!	Factorization scheme
+    LDLTSchemes Scheme_;
+
+//!	Maximum number of columns in a panel of the blocked scheme
+    unsigned int BlockSize_;
+
+//!	Memory budget in bytes for the columns of an out of core matrix
+    size_t MemoryBudget_;
+
+//!	First column of each block of an out of core matrix, followed by N+1
+    vector<unsigned int> BlockStart_;
+
+//!	Reduce the columns First:Last one by one, the columns 1:First-1 being already reduced
+    void ReduceColumns(unsigned int First, unsigned int Last);
+
+//!	Reduce the columns First:Last by panels, the columns 1:First-1 being already reduced
+    void ReducePanels(unsigned int First, unsigned int Last);
+
+//!	Split the columns of an out of core matrix into blocks that fit in the memory budget
+    void PartitionColumns();
+
 public:
 
 //!	Constructor
-	CLDLTSolver(CSkylineMatrix<double>* K): K(*K) {};
+	CLDLTSolver(CSkylineMatrix<double>* K, LDLTSchemes Scheme = ColumnReduction, unsigned int BlockSize = 32)
+		: K(*K), Scheme_(Scheme), BlockSize_(BlockSize), MemoryBudget_(0) {};
+
+//!	Set the memory budget in bytes used for the columns of an out of core matrix
+	inline void SetMemoryBudget(size_t Budget) { MemoryBudget_ = Budget; }
+
+//!	Perform L*D*L(T) factorization of the stiffness matrix with the selected scheme
+/*!	An out of core matrix is always factorized by OutOfCoreLDLT. The factorization resumes at
+	column FirstColumn, the columns 1:FirstColumn-1 holding their factors already */
+	void LDLT(unsigned int FirstColumn = 1);
+
+//!	Perform L*D*L(T) factorization column by column
+	void ColumnLDLT(unsigned int FirstColumn = 1);
+
+//!	Perform L*D*L(T) factorization by panels of adjacent columns with overlapping profiles
+	void BlockedLDLT(unsigned int FirstColumn = 1);
+
+//!	Perform L*D*L(T) factorization on several threads, following the column dependencies
+	void ParallelLDLT(unsigned int FirstColumn = 1);
 
-//!	Perform L*D*L(T) factorization of the stiffness matrix
-	void LDLT();
+//!	Perform L*D*L(T) factorization of an out of core matrix block by block
+/*!	The blocks are reduced by panels with the blocked scheme, and column by column otherwise */
+	void OutOfCoreLDLT(unsigned int FirstColumn = 1);
+
+//!	Return the number of multiply-adds of the factorization of the columns FirstColumn:N,
+//!	estimated from the column heights
+	double CountFactorization(unsigned int FirstColumn = 1);
 
 //!	Reduce right-hand-side load vector and back substitute
-	void BackSubstitution(double* Force); 
+	void BackSubstitution(double* Force) { BackSubstitution(Force, 1); }
+
+//!	Reduce the right-hand-side load vectors of NRHS load cases and back substitute them at once
+/*!	Force[(i-1)*NRHS + k] is the load of equation i (numbering from 1) in load case k, i.e. the
+	loads of all load cases for one equation are stored contiguously */
+	void BackSubstitution(double* Force, unsigned int NRHS);
+};
+
+//!	Low rank update of a factorized stiffness matrix by the Sherman-Morrison-Woodbury formula
+/*!	The equations (K + P C P(T)) a = R of a changed model are solved with the L*D*L(T)
+	factorization of K, where P selects the m equations touched by the changed elements and
+	C (m x m) is the difference of their element stiffness matrices on these equations:
+		a = y - Z (I + C W)^(-1) C P(T) y,  with y = K^(-1) R, Z = K^(-1) P and W = P(T) Z
+	Z costs m load cases of back substitution, after which each load case costs O(NEQ*m)
+	in addition to its back substitution instead of a new factorization */
+class CLowRankUpdate
+{
+private:
+
+    CLDLTSolver& Solver_;
+
+//!	Number of equations of the stiffness matrix
+    unsigned int NEQ_;
+
+//!	Equations (numbering from 1) touched by the update
+    vector<unsigned int> Equations_;
+
+//!	Update C of the stiffness matrix on Equations_ ([m][m])
+    vector<double> Update_;
+
+//!	Z = K^(-1) P ([NEQ][m], the m columns of an equation stored contiguously)
+    vector<double> Z_;
+
+//!	LU factors of I + C W ([m][m]) with row interchanges Pivots_
+    vector<double> LU_;
+    vector<unsigned int> Pivots_;
+
+public:
+
+//!	Largest rank m of an update, above which the changed columns are factorized again instead
+	const static unsigned int MaximumRank = 256;
+
+//!	Constructor
+	CLowRankUpdate(CLDLTSolver* Solver, unsigned int NEQ, const vector<unsigned int>& Equations,
+				   const vector<double>& Update)
+		: Solver_(*Solver), NEQ_(NEQ), Equations_(Equations), Update_(Update) {};
+
+//!	Calculate Z and the LU factorization of I + C W
+/*!	Return false if the updated stiffness matrix is singular */
+	bool Factorize();
+
+//!	Correct the solutions y of the factorized stiffness matrix K, obtained by BackSubstitution
+//!	for NRHS load cases, to the solutions of the updated stiffness matrix
+	void Correct(double* Force, unsigned int NRHS);
+
+//!	Return the rank m of the update
+	inline unsigned int GetRank() const { return (unsigned int)Equations_.size(); }
+};
+
+//!	PCG solver: An iterative solver using compressed sparse row storage and preconditioned conjugate gradients
+class CPCGSolver
+{
+private:
+
+    CSparseMatrix<double>& K;
+
+//!	Preconditioner
+    Preconditioners Preconditioner_;
+
+//!	Convergence tolerance of the relative residual norm |R - K a| / |R|
+    double Tolerance_;
+
+//!	Maximum number of iterations
+    unsigned int MaxIterations_;
+
+//!	Inverse of the diagonal (Jacobi), or the upper triangular factor U of K = U(T)*U
+//!	with the sparsity pattern of K (incomplete Cholesky)
+    vector<double> M_;
+
+//!	Number of iterations and relative residual norm of the last solution
+    unsigned int Iterations_;
+    double Residual_;
+
+//!	Apply the preconditioner z = M^(-1) r
+    void Precondition(const double* r, double* z);
+
+public:
+
+//!	Constructor
+	CPCGSolver(CSparseMatrix<double>* K, Preconditioners Preconditioner = JacobiPreconditioner,
+			   double Tolerance = 1.0E-10, unsigned int MaxIterations = 0);
+
+//!	Calculate the preconditioner of the stiffness matrix
+	void Factorize();
+
+//!	Solve the displacement for the load vector Force, which is overwritten by the displacement
+/*!	Return false if the solution did not converge in MaxIterations iterations */
+	bool Solve(double* Force);
+
+//!	Return the number of iterations of the last solution
+	inline unsigned int GetIterations() const { return Iterations_; }
+
+//!	Return the relative residual norm of the last solution
+	inline double GetResidual() const { return Residual_; }
 };
@@ -0,0 +1,253 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+
+//! CSparseMatrix class is used to store the FEM stiffness matrix in compressed sparse row storage
+/*! Only the upper triangular part (including the diagonal) of the symmetric matrix is stored.
+    The columns of each row are sorted, and the first entry of each row is the diagonal element.
+    The sparsity pattern is built in two passes over the location matrices of all elements:
+    CountEntries for every element, AllocatePattern, AddEntries for every element and
+    CompressPattern. */
+template <class T_>
+class CSparseMatrix
+{
+
+private:
+//! Values of the stored entries
+    T_* data_;
+
+//! Dimension of the stiffness matrix
+    unsigned int NEQ_;
+
+//! Number of stored entries
+    size_t NNZ_;
+
+//! Position of the first entry of each row in data_ and ColumnIndices_ (NEQ_ + 1 entries)
+    size_t* RowStart_;
+
+//! Column number of each stored entry (numbering from 1)
+    unsigned int* ColumnIndices_;
+
+public:
+
+//! constructors
+    inline CSparseMatrix(unsigned int N);
+
+//! destructor
+    inline ~CSparseMatrix();
+
+//! Count the entries contributed by an element (first pass, duplicates included)
+    void CountEntries(unsigned int* LocationMatrix, size_t ND);
+
+//! Allocate the column indices for the counted entries
+    void AllocatePattern();
+
+//! Add the entries contributed by an element (second pass)
+    void AddEntries(unsigned int* LocationMatrix, size_t ND);
+
+//! Sort the columns of each row, remove duplicates and allocate the values
+    void CompressPattern();
+
+//! operator (i,j) where i <= j are numbering from 1
+//! The entry must be in the sparsity pattern
+    inline T_& operator()(unsigned int i, unsigned int j);
+
+//! Assemble the element stiffness matrix to the global stiffness matrix
+    void Assembly(double* Matrix, unsigned int* LocationMatrix, size_t ND);
+
+//! Matrix vector product y = K x
+    void Multiply(const T_* x, T_* y) const;
+
+//! Return pointer to the values
+    inline T_* data() { return data_; }
+
+//! Return pointer to the RowStart_
+    inline size_t* GetRowStart() { return RowStart_; }
+
+//! Return pointer to the ColumnIndices_
+    inline unsigned int* GetColumnIndices() { return ColumnIndices_; }
+
+//! Return the dimension of the stiffness matrix
+    inline unsigned int dim() const { return NEQ_; }
+
+//! Return the number of stored entries
+    inline size_t size() const { return NNZ_; }
+
+}; /* class definition */
+
+//! constructor function
+template <class T_>
+inline CSparseMatrix<T_>::CSparseMatrix(unsigned int N)
+{
+    NEQ_ = N;
+    NNZ_ = 0;
+
+    data_ = nullptr;
+    ColumnIndices_ = nullptr;
+
+    RowStart_ = new size_t [NEQ_ + 1];
+    for (unsigned int i = 0; i <= NEQ_; i++)
+        RowStart_[i] = 0;
+}
+
+//! destructor function
+template <class T_>
+inline CSparseMatrix<T_>::~CSparseMatrix()
+{
+    delete [] RowStart_;
+    delete [] ColumnIndices_;
+    delete [] data_;
+}
+
+//  Count the entries contributed by an element (first pass, duplicates included)
+//  RowStart_[i] temporarily holds the number of entries of row i
+template <class T_>
+void CSparseMatrix<T_>::CountEntries(unsigned int* LocationMatrix, size_t ND)
+{
+    for (size_t i = 0; i < ND; i++)
+    {
+        unsigned int Li = LocationMatrix[i];
+        if (!Li) continue;
+
+        for (size_t j = 0; j < ND; j++)
+            if (LocationMatrix[j] >= Li)
+                RowStart_[Li]++;
+    }
+}
+
+//  Allocate the column indices for the counted entries
+//  The diagonal element is reserved as the first entry of each row
+template <class T_>
+void CSparseMatrix<T_>::AllocatePattern()
+{
+    for (unsigned int i = 1; i <= NEQ_; i++)
+        RowStart_[i] += RowStart_[i-1] + 1;
+
+    NNZ_ = RowStart_[NEQ_];
+    ColumnIndices_ = new unsigned int [NNZ_];
+
+//  RowStart_[i] is used as the fill pointer of row i+1 until the pattern is compressed
+    for (unsigned int i = NEQ_; i > 0; i--)
+    {
+        RowStart_[i] = RowStart_[i-1] + 1;
+        ColumnIndices_[RowStart_[i-1]] = i;
+    }
+}
+
+//  Add the entries contributed by an element (second pass)
+template <class T_>
+void CSparseMatrix<T_>::AddEntries(unsigned int* LocationMatrix, size_t ND)
+{
+    for (size_t i = 0; i < ND; i++)
+    {
+        unsigned int Li = LocationMatrix[i];
+        if (!Li) continue;
+
+        for (size_t j = 0; j < ND; j++)
+            if (LocationMatrix[j] >= Li)
+                ColumnIndices_[RowStart_[Li]++] = LocationMatrix[j];
+    }
+}
+
+//  Sort the columns of each row, remove duplicates and allocate the values
+template <class T_>
+void CSparseMatrix<T_>::CompressPattern()
+{
+    size_t First = 0;   // Start of row i in the uncompressed pattern
+    size_t NNZ = 0;
+
+    for (unsigned int i = 1; i <= NEQ_; i++)
+    {
+        size_t Last = RowStart_[i];
+
+        std::sort(ColumnIndices_ + First, ColumnIndices_ + Last);
+        unsigned int* End = std::unique(ColumnIndices_ + First, ColumnIndices_ + Last);
+
+        size_t Start = NNZ;
+        for (unsigned int* p = ColumnIndices_ + First; p < End; p++)
+            ColumnIndices_[NNZ++] = *p;
+
+        RowStart_[i-1] = Start;
+        First = Last;
+    }
+
+    RowStart_[NEQ_] = NNZ;
+
+    unsigned int* ColumnIndices = new unsigned int [NNZ];
+    std::copy(ColumnIndices_, ColumnIndices_ + NNZ, ColumnIndices);
+    delete [] ColumnIndices_;
+
+    ColumnIndices_ = ColumnIndices;
+    NNZ_ = NNZ;
+
+    data_ = new T_ [NNZ_];
+    for (size_t k = 0; k < NNZ_; k++)
+        data_[k] = T_(0);
+}
+
+//  operator function (i,j) where i <= j are numbering from 1
+template <class T_>
+inline T_& CSparseMatrix<T_>::operator()(unsigned int i, unsigned int j)
+{
+    unsigned int* p = std::lower_bound(ColumnIndices_ + RowStart_[i-1], ColumnIndices_ + RowStart_[i], j);
+    return data_[p - ColumnIndices_];
+}
+
+//  Assemble the element stiffness matrix (upper triangular, stored column by column) to the global matrix
+template <class T_>
+void CSparseMatrix<T_>::Assembly(double* Matrix, unsigned int* LocationMatrix, size_t ND)
+{
+    for (unsigned int j = 0; j < ND; j++)
+    {
+        unsigned int Lj = LocationMatrix[j];    // Global equation number corresponding to jth DOF of the element
+        if (!Lj) continue;
+
+//      Address of diagonal element of column j in the one dimensional element stiffness matrix
+        unsigned int DiagjElement = (j+1)*j/2;
+
+        for (unsigned int i = 0; i <= j; i++)
+        {
+            unsigned int Li = LocationMatrix[i];    // Global equation number corresponding to ith DOF of the element
+            if (!Li) continue;
+
+            if (Li <= Lj)
+                (*this)(Li,Lj) += Matrix[DiagjElement + j - i];
+            else
+                (*this)(Lj,Li) += Matrix[DiagjElement + j - i];
+        }
+    }
+}
+
+//  Matrix vector product y = K x, using the symmetry of K
+template <class T_>
+void CSparseMatrix<T_>::Multiply(const T_* x, T_* y) const
+{
+    for (unsigned int i = 0; i < NEQ_; i++)
+        y[i] = T_(0);
+
+    for (unsigned int i = 0; i < NEQ_; i++)
+    {
+        size_t k = RowStart_[i];
+        T_ yi = data_[k] * x[i];    // Diagonal element
+        T_ xi = x[i];
+
+        for (k++; k < RowStart_[i+1]; k++)
+        {
+            unsigned int j = ColumnIndices_[k] - 1;
+            yi += data_[k] * x[j];
+            y[j] += data_[k] * xi;
+        }
+
+        y[i] += yi;
+    }
+}
@@ -0,0 +1,143 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+#pragma once
+
+#include "MappedFile.h"
+#include "Parallel.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//!	CTokenizer class reads numbers from a text input data file
+/*!	The file is mapped into memory and the numbers are converted in place, without the locale
+	and buffer handling of the stream extraction operators. The operators >> follow the same
+	rules as for an ifstream: white space is skipped, the longest valid number is converted,
+	and after a failed conversion all further extractions fail. Decimal numbers whose
+	significant digits fit in 53 bits and whose decimal exponent is within +-22 are converted
+	exactly with one floating point operation; all other numbers are converted by strtod, so
+	the results are identical to those of the stream extraction.
+	Blocks of records with one record per line can be read in parallel by ReadLines */
+class CTokenizer
+{
+private:
+
+//!	Mapping of the input data file
+	CMappedFile File_;
+
+//!	Current position and end of the data
+	const char* Current_;
+	const char* End_;
+
+//!	True after a failed extraction
+	bool Fail_;
+
+//!	Skip white space, set the failure flag at the end of the data
+	inline bool SkipSpace();
+
+//!	Split the next Count non-blank lines into Parts contiguous ranges of whole lines
+//!	Range p holds the lines [Count*p/Parts, Count*(p+1)/Parts) and spans [Bounds[p], Bounds[p+1])
+//!	Return false if less than Count non-blank lines are left
+	bool SplitLines(unsigned int Count, unsigned int Parts, vector<const char*>& Bounds);
+
+public:
+
+//!	Minimum number of lines read in parallel by ReadLines
+	const static unsigned int MinimumParallelLines = 4096;
+
+//!	Constructor
+	CTokenizer() : Current_(nullptr), End_(nullptr), Fail_(true) {};
+
+//!	Constructor of a tokenizer reading the characters [Begin, End) of the data of another one
+	CTokenizer(const char* Begin, const char* End) : Current_(Begin), End_(End), Fail_(false) {};
+
+//!	Map the input data file FileName, return false if it cannot be opened
+	bool Open(const string& FileName);
+
+//!	Return false after a failed extraction
+	explicit operator bool() const { return !Fail_; }
+
+//!	Return true after a failed extraction
+	bool operator!() const { return Fail_; }
+
+//!	Read the rest of the current line into s, storing at most n-1 characters
+//!	The end of line is extracted, but not stored
+	void getline(char* s, size_t n);
+
+//!	Return the rest of the current line, and extract the end of line
+	string GetRestOfLine();
+
+//!	Extract an unsigned integer
+	CTokenizer& operator>>(unsigned int& Value);
+
+//!	Extract an integer
+	CTokenizer& operator>>(int& Value);
+
+//!	Extract a floating point number
+	CTokenizer& operator>>(double& Value);
+
+//!	Return true if only white space is left
+	bool AtEnd();
+
+//!	Read the next Count records, of one line each, on all threads
+/*!	The lines are split into one contiguous range per thread, and Record(Chunk, i) reads record i
+	from the tokenizer Chunk of its range and returns false if the record is invalid. The read
+	position is only moved if all records are valid and each range holds exactly its records.
+	Otherwise, or with a single thread, ReadLines returns false and the caller reads the records
+	serially, which reports the errors as before */
+	template <class Function>
+	bool ReadLines(unsigned int Count, Function Record);
+
+//!	Return the size of the input data file in bytes
+	inline size_t size() const { return File_.size(); }
+};
+
+//	Read the next Count records, of one line each, on all threads
+template <class Function>
+bool CTokenizer::ReadLines(unsigned int Count, Function Record)
+{
+	unsigned int NT = CParallel::GetNumberOfThreads();
+
+	if (NT <= 1 || Count < MinimumParallelLines || Fail_)
+		return false;
+
+	vector<const char*> Bounds;
+	if (!SplitLines(Count, NT, Bounds))
+		return false;
+
+	vector<char> Valid(NT, 0);
+
+	CParallel::For(0, NT, [&](unsigned int Begin, unsigned int End, unsigned int)
+	{
+		for (unsigned int p = Begin; p < End; p++)
+		{
+			CTokenizer Chunk(Bounds[p], Bounds[p + 1]);
+
+			unsigned int First = (unsigned int)((unsigned long long)Count * p / NT);
+			unsigned int Last = (unsigned int)((unsigned long long)Count * (p + 1) / NT);
+
+			bool Success = true;
+			for (unsigned int i = First; i < Last && Success; i++)
+				Success = Record(Chunk, i) && !!Chunk;
+
+			Valid[p] = Success && Chunk.AtEnd();
+		}
+	});
+
+	for (unsigned int p = 0; p < NT; p++)
+		if (!Valid[p])
+			return false;
+
+	Current_ = Bounds[NT];
+
+	return true;
+}
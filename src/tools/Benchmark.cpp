@@ -0,0 +1,417 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+//	Benchmark of the solution phases of stap++ on generated input data files
+//	A plane truss or a space lattice of the given number of cells is written to a text input
+//	data file, which is then solved several times in the same way as by stap++. The wall clock
+//	time of every phase is measured in each repetition, and the minimum, median, mean and
+//	maximum over the repetitions are printed as comma separated values for regression tracking.
+
+#include "Domain.h"
+#include "Outputter.h"
+#include "Parallel.h"
+#include "Kernels.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+//	Print help message
+void PrintUsage()
+{
+	cout << "Usage: stap++bench [options] plane NX NY | space NX NY NZ\n"
+		 << "    plane NX NY              Plane truss of NX x NY cross braced cells in the x-y plane\n"
+		 << "    space NX NY NZ           Space lattice of NX x NY x NZ cells with braced faces, fixed at z = 0\n"
+		 << "Options:\n"
+		 << "    -loads N                 Number of load cases (default 4)\n"
+		 << "    -reps N                  Number of repetitions of the solution (default 5)\n"
+		 << "    -t N                     Number of threads used in the solution (0 : all cores, default 1)\n"
+		 << "    -ldlt column | blocked | parallel\n"
+		 << "                             Factorization scheme of the LDLT solver (default column)\n"
+		 << "    -reorder                 Renumber the equations by reverse Cuthill-McKee ordering\n"
+		 << "    -o FILE                  Append the results to FILE instead of printing them\n"
+		 << "    -keep                    Keep the generated input data file and the output file\n";
+}
+
+//	Nodes, bars and loads of a generated truss
+struct CTruss
+{
+	vector<double> Coordinates;	// [NUMNP][3]
+	vector<unsigned int> Codes;	// Boundary codes [NUMNP][3]
+	vector<unsigned int> Bars;	// Nodes (numbering from 1) and material set of the bars [NUME][3]
+
+	vector<vector<unsigned int>> Loads;	// Node and direction of the loads of each load case
+
+	void AddNode(double x, double y, double z, unsigned int bx, unsigned int by, unsigned int bz)
+	{
+		Coordinates.insert(Coordinates.end(), {x, y, z});
+		Codes.insert(Codes.end(), {bx, by, bz});
+	}
+
+	void AddBar(unsigned int Node1, unsigned int Node2, unsigned int Set)
+	{
+		Bars.insert(Bars.end(), {Node1, Node2, Set});
+	}
+};
+
+//	Plane truss of NX x NY cells with both diagonals, whose nodes at x = 0 are fixed and whose
+//	nodes are all fixed in z. Each load case loads a node at x = NX
+void GeneratePlaneTruss(CTruss& Truss, unsigned int NX, unsigned int NY, unsigned int NLCASE)
+{
+	auto Node = [=](unsigned int i, unsigned int j) { return j * (NX + 1) + i + 1; };
+
+	for (unsigned int j = 0; j <= NY; j++)
+		for (unsigned int i = 0; i <= NX; i++)
+			Truss.AddNode(i, j, 0.0, i == 0, i == 0, 1);
+
+	for (unsigned int j = 0; j <= NY; j++)
+		for (unsigned int i = 0; i <= NX; i++)
+		{
+			if (i < NX)
+				Truss.AddBar(Node(i, j), Node(i + 1, j), 1);
+			if (j < NY)
+				Truss.AddBar(Node(i, j), Node(i, j + 1), 1);
+			if (i < NX && j < NY)
+			{
+				Truss.AddBar(Node(i, j), Node(i + 1, j + 1), 2);
+				Truss.AddBar(Node(i + 1, j), Node(i, j + 1), 2);
+			}
+		}
+
+	for (unsigned int lcase = 0; lcase < NLCASE; lcase++)
+		Truss.Loads.push_back({Node(NX, lcase % (NY + 1)), lcase % 2 + 1});
+}
+
+//	Space lattice of NX x NY x NZ cells, with one diagonal on every face so that each cell is
+//	rigid, whose nodes at z = 0 are fixed. Each load case loads a node at z = NZ
+void GenerateSpaceLattice(CTruss& Truss, unsigned int NX, unsigned int NY, unsigned int NZ, unsigned int NLCASE)
+{
+	auto Node = [=](unsigned int i, unsigned int j, unsigned int k) { return (k * (NY + 1) + j) * (NX + 1) + i + 1; };
+
+	for (unsigned int k = 0; k <= NZ; k++)
+		for (unsigned int j = 0; j <= NY; j++)
+			for (unsigned int i = 0; i <= NX; i++)
+				Truss.AddNode(i, j, k, k == 0, k == 0, k == 0);
+
+	for (unsigned int k = 0; k <= NZ; k++)
+		for (unsigned int j = 0; j <= NY; j++)
+			for (unsigned int i = 0; i <= NX; i++)
+			{
+				if (i < NX)
+					Truss.AddBar(Node(i, j, k), Node(i + 1, j, k), 1);
+				if (j < NY)
+					Truss.AddBar(Node(i, j, k), Node(i, j + 1, k), 1);
+				if (k < NZ)
+					Truss.AddBar(Node(i, j, k), Node(i, j, k + 1), 1);
+				if (i < NX && j < NY)
+					Truss.AddBar(Node(i, j, k), Node(i + 1, j + 1, k), 2);
+				if (i < NX && k < NZ)
+					Truss.AddBar(Node(i, j, k), Node(i + 1, j, k + 1), 2);
+				if (j < NY && k < NZ)
+					Truss.AddBar(Node(i, j, k), Node(i, j + 1, k + 1), 2);
+			}
+
+	for (unsigned int lcase = 0; lcase < NLCASE; lcase++)
+		Truss.Loads.push_back({Node(lcase % (NX + 1), lcase / (NX + 1) % (NY + 1), NZ), lcase % 3 + 1});
+}
+
+//	Write the truss to the text input data file FileName
+bool WriteInputData(const string& FileName, const string& Title, const CTruss& Truss)
+{
+	FILE* File = fopen(FileName.c_str(), "w");
+	if (!File)
+		return false;
+
+	unsigned int NUMNP = (unsigned int)(Truss.Coordinates.size() / 3);
+	unsigned int NUME = (unsigned int)(Truss.Bars.size() / 3);
+
+	fprintf(File, "%s\n%u 1 %u 1\n", Title.c_str(), NUMNP, (unsigned int)Truss.Loads.size());
+
+	for (unsigned int np = 0; np < NUMNP; np++)
+		fprintf(File, "%u %u %u %u %g %g %g\n", np + 1, Truss.Codes[3 * np], Truss.Codes[3 * np + 1],
+				Truss.Codes[3 * np + 2], Truss.Coordinates[3 * np], Truss.Coordinates[3 * np + 1],
+				Truss.Coordinates[3 * np + 2]);
+
+	for (unsigned int lcase = 0; lcase < Truss.Loads.size(); lcase++)
+		fprintf(File, "%u 1\n%u %u 1000.0\n", lcase + 1, Truss.Loads[lcase][0], Truss.Loads[lcase][1]);
+
+	fprintf(File, "1 %u 2\n1 2.1e11 1e-4\n2 7.0e10 2e-4\n", NUME);
+
+	for (unsigned int Ele = 0; Ele < NUME; Ele++)
+		fprintf(File, "%u %u %u %u\n", Ele + 1, Truss.Bars[3 * Ele], Truss.Bars[3 * Ele + 1], Truss.Bars[3 * Ele + 2]);
+
+	return fclose(File) == 0;
+}
+
+//	Phases of the solution, in the order of the output
+enum Phases
+{
+	InputPhase = 0,		// Reading of the input data file, including parse, numbering and echo
+	ParsePhase,			// Parse of the input data file
+	NumberingPhase,		// Equation numbering
+	ColumnHeightsPhase,	// Column heights and diagonal addresses
+	AllocationPhase,	// Allocation of the matrices, including the column heights
+	AssemblyPhase,		// Assembly of the stiffness matrix
+	LDLTPhase,			// Factorization of the stiffness matrix
+	LoadPhase,			// Assembly of the load vectors
+	BackSubstitutionPhase,	// Reduction and back substitution of the load vectors
+	StressPhase,		// Calculation of the element stresses
+	OutputPhase,		// Output of the displacements and stresses, until written to the output file
+	TotalPhase,			// All phases
+	NumberOfPhases
+};
+
+const char* PhaseNames[NumberOfPhases] = {"input", "parse", "numbering", "column heights", "allocation",
+										  "assembly", "ldlt", "loads", "back substitution", "stress",
+										  "output", "total"};
+
+//	Wall clock time in seconds
+double Now()
+{
+	return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int NLCASE = 4;
+	unsigned int Repetitions = 5;
+	LDLTSchemes Scheme = ColumnReduction;
+	string SchemeName = "column";
+	bool Reorder = false;
+	bool Keep = false;
+	string ResultsFile;
+
+	int arg = 1;
+	for (; arg < argc && argv[arg][0] == '-'; arg++)
+	{
+		string option(argv[arg]);
+
+		if (option == "-loads" && arg + 1 < argc)
+			NLCASE = max(atoi(argv[++arg]), 1);
+		else if (option == "-reps" && arg + 1 < argc)
+			Repetitions = max(atoi(argv[++arg]), 1);
+		else if (option == "-t" && arg + 1 < argc)
+			CParallel::SetNumberOfThreads(atoi(argv[++arg]));
+		else if (option == "-ldlt" && arg + 1 < argc)
+		{
+			SchemeName = argv[++arg];
+
+			if (SchemeName == "column")
+				Scheme = ColumnReduction;
+			else if (SchemeName == "blocked")
+				Scheme = BlockedReduction;
+			else if (SchemeName == "parallel")
+				Scheme = ParallelReduction;
+			else
+			{
+				cout << "*** Error *** Invalid LDLT scheme: " << SchemeName << endl;
+				exit(1);
+			}
+		}
+		else if (option == "-reorder")
+			Reorder = true;
+		else if (option == "-o" && arg + 1 < argc)
+			ResultsFile = argv[++arg];
+		else if (option == "-keep")
+			Keep = true;
+		else
+		{
+			cout << "*** Error *** Invalid option: " << option << endl;
+			PrintUsage();
+			exit(1);
+		}
+	}
+
+//	Generate the truss
+	string Mesh = arg < argc ? argv[arg] : "";
+	unsigned int Dimensions = (Mesh == "plane") ? 2 : (Mesh == "space") ? 3 : 0;
+
+	if (!Dimensions || argc - arg != (int)Dimensions + 1)
+	{
+		PrintUsage();
+		exit(1);
+	}
+
+	unsigned int Cells[3] = {1, 1, 1};
+	string Size;
+
+	for (unsigned int d = 0; d < Dimensions; d++)
+	{
+		Cells[d] = max(atoi(argv[arg + 1 + d]), 1);
+		Size += (d ? "x" : "") + to_string(Cells[d]);
+	}
+
+	CTruss Truss;
+	if (Dimensions == 2)
+		GeneratePlaneTruss(Truss, Cells[0], Cells[1], NLCASE);
+	else
+		GenerateSpaceLattice(Truss, Cells[0], Cells[1], Cells[2], NLCASE);
+
+	string Name = "bench_" + Mesh + "_" + Size;
+	string InFile = Name + ".dat";
+	string OutFile = Name + ".out";
+
+	if (!WriteInputData(InFile, "Benchmark " + Mesh + " " + Size, Truss))
+	{
+		cerr << "*** Error *** File " << InFile << " cannot be written !" << endl;
+		exit(3);
+	}
+
+//	Solve the problem Repetitions times as stap++ does, timing each phase
+	COutputter::SetConsole(false);
+
+	vector<vector<double>> Times(NumberOfPhases);
+	unsigned int NUMNP = 0, NUME = 0, NEQ = 0;
+	size_t NWK = 0;
+
+	for (unsigned int rep = 0; rep < Repetitions; rep++)
+	{
+		double Time[NumberOfPhases] = {0};
+		double Start = Now(), Begin = Start;
+
+		auto Lap = [&](Phases Phase)
+		{
+			double End = Now();
+			Time[Phase] += End - Begin;
+			Begin = End;
+		};
+
+		CDomain* FEMData = CDomain::GetInstance();
+		FEMData->SetReorder(Reorder);
+
+		if (!FEMData->ReadData(InFile, OutFile))
+		{
+			cerr << "*** Error *** Data input failed!" << endl;
+			exit(1);
+		}
+
+		Lap(InputPhase);
+
+		FEMData->AllocateMatrices();
+		Lap(AllocationPhase);
+
+		FEMData->AssembleStiffnessMatrix();
+		Lap(AssemblyPhase);
+
+		CLDLTSolver Solver(FEMData->GetStiffnessMatrix(), Scheme);
+		Solver.LDLT();
+		Lap(LDLTPhase);
+
+		COutputter* Output = COutputter::GetInstance();
+		unsigned int NumberOfCases = 1;
+
+		for (unsigned int lcase = 0; lcase < NLCASE; lcase++)
+		{
+			unsigned int k = lcase % CDomain::NRHS;
+
+			if (k == 0)
+			{
+				NumberOfCases = min(CDomain::NRHS, NLCASE - lcase);
+
+				FEMData->AssembleForceBlock(lcase + 1, NumberOfCases);
+				Lap(LoadPhase);
+
+				Solver.BackSubstitution(FEMData->GetForceBlock(), NumberOfCases);
+			}
+
+			FEMData->ExtractDisplacement(k, NumberOfCases);
+			Lap(BackSubstitutionPhase);
+
+			*Output << " LOAD CASE" << setw(5) << lcase + 1 << endl << endl << endl;
+			Output->OutputNodalDisplacement();
+			Lap(OutputPhase);
+
+			FEMData->CalculateStresses();
+			Lap(StressPhase);
+
+			Output->OutputElementStress();
+			Lap(OutputPhase);
+		}
+
+		Output->Flush();
+		Lap(OutputPhase);
+
+		Time[ParsePhase] = FEMData->GetParseTime();
+		Time[NumberingPhase] = FEMData->GetNumberingTime();
+		Time[ColumnHeightsPhase] = FEMData->GetColumnHeightsTime();
+		Time[TotalPhase] = Begin - Start;
+
+		for (unsigned int Phase = 0; Phase < NumberOfPhases; Phase++)
+			Times[Phase].push_back(Time[Phase]);
+
+		NUMNP = FEMData->GetNUMNP();
+		NEQ = FEMData->GetNEQ();
+		NWK = FEMData->GetStiffnessMatrix()->size();
+
+		NUME = 0;
+		for (unsigned int EleGrp = 0; EleGrp < FEMData->GetNUMEG(); EleGrp++)
+			NUME += FEMData->GetEleGrpList()[EleGrp].GetNUME();
+
+		CDomain::DeleteInstance();
+
+//		The output file is written again from the beginning in the next repetition
+		COutputter::DeleteInstance();
+	}
+
+//	Print the statistics of each phase over the repetitions
+	ofstream File;
+	if (!ResultsFile.empty())
+	{
+		bool Header = !ifstream(ResultsFile).good();
+
+		File.open(ResultsFile, ios::app);
+		if (!File)
+		{
+			cerr << "*** Error *** File " << ResultsFile << " cannot be written !" << endl;
+			exit(3);
+		}
+
+		if (Header)
+			File << "mesh,size,numnp,nume,neq,nwk,nlcase,threads,scheme,reorder,simd,phase,reps,min,median,mean,max" << endl;
+	}
+	else
+		cout << "mesh,size,numnp,nume,neq,nwk,nlcase,threads,scheme,reorder,simd,phase,reps,min,median,mean,max" << endl;
+
+	ostream& Results = ResultsFile.empty() ? cout : File;
+	Results << setprecision(6);
+
+	for (unsigned int Phase = 0; Phase < NumberOfPhases; Phase++)
+	{
+		vector<double>& Samples = Times[Phase];
+		sort(Samples.begin(), Samples.end());
+
+		double Sum = 0.0;
+		for (double t : Samples)
+			Sum += t;
+
+		size_t n = Samples.size();
+		double Median = (n % 2) ? Samples[n / 2] : 0.5 * (Samples[n / 2 - 1] + Samples[n / 2]);
+
+		Results << Mesh << ',' << Size << ',' << NUMNP << ',' << NUME << ',' << NEQ << ',' << NWK << ',' << NLCASE << ','
+				<< CParallel::GetNumberOfThreads() << ',' << SchemeName << ',' << Reorder << ','
+				<< CKernels::GetLevelName(CKernels::GetLevel()) << ',' << PhaseNames[Phase] << ',' << n << ','
+				<< Samples.front() << ',' << Median << ',' << Sum / n << ',' << Samples.back() << '\n';
+	}
+
+	Results.flush();
+
+	if (!Keep)
+	{
+		remove(InFile.c_str());
+		remove(OutFile.c_str());
+	}
+
+	return 0;
+}
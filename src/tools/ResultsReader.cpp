@@ -0,0 +1,187 @@
+/*****************************************************************************/
+/*  STAP++ : A C++ FEM code sharing the same input data file with STAP90     */
+/*     Computational Dynamics Laboratory                                     */
+/*     School of Aerospace Engineering, Tsinghua University                  */
+/*                                                                           */
+/*     Release 1.11, November 22, 2017                                       */
+/*                                                                           */
+/*     http://www.comdyn.cn/                                                 */
+/*****************************************************************************/
+
+//	Reader of the binary results file (.bres) written by stap++ -results binary
+//	Without options, the extreme values of every load case are printed. With -case N, the
+//	displacements and stresses of load case N are printed in the format of the output file.
+
+#include "ResultsFile.h"
+
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+//	Print help message
+void PrintUsage()
+{
+	cout << "Usage: stap++results [options] ResultsFileName\n"
+		 << "    ResultsFileName is a binary results file (.bres) written by stap++ -results binary\n"
+		 << "Options:\n"
+		 << "    -case N                  Print the displacements and stresses of load case N\n"
+		 << "                             (default: print the extreme values of all load cases)\n";
+}
+
+//	Print the displacements and stresses of the lcase-th load case in the file
+void PrintLoadCase(CResultsFile& Results, unsigned int lcase)
+{
+	cout << setiosflags(ios::scientific) << setprecision(5);
+
+	cout << " LOAD CASE" << setw(5) << Results.GetLoadCase(lcase) << endl << endl << endl;
+
+	cout << " D I S P L A C E M E N T S" << endl
+		 << endl;
+	cout << "  NODE           X-DISPLACEMENT    Y-DISPLACEMENT    Z-DISPLACEMENT" << endl;
+
+	const double* Displacements = Results.GetDisplacements(lcase);
+	unsigned int NDF = Results.GetNDF();
+
+	for (unsigned int np = 0; np < Results.GetNUMNP(); np++)
+	{
+		cout << setw(5) << np + 1 << "        ";
+
+		for (unsigned int dof = 0; dof < NDF; dof++)
+			cout << setw(18) << Displacements[(size_t)np * NDF + dof];
+
+		cout << '\n';
+	}
+
+	cout << endl;
+
+	for (unsigned int EleGrp = 0; EleGrp < Results.GetNUMEG(); EleGrp++)
+	{
+		cout << " S T R E S S  C A L C U L A T I O N S  F O R  E L E M E N T  G R O U P" << setw(5)
+			 << EleGrp + 1 << endl
+			 << endl;
+
+		const double* Stresses = Results.GetStresses(lcase, EleGrp);
+		unsigned int NCOL = Results.GetNCOL(EleGrp);
+
+		if (NCOL == 2)	// Bar element
+			cout << "  ELEMENT             FORCE            STRESS" << endl
+				 << "  NUMBER" << endl;
+
+		for (unsigned int Ele = 0; Ele < Results.GetNUME(EleGrp); Ele++)
+		{
+			cout << setw(5) << Ele + 1 << setw(22) << Stresses[(size_t)Ele * NCOL];
+
+			for (unsigned int col = 1; col < NCOL; col++)
+				cout << setw(18) << Stresses[(size_t)Ele * NCOL + col];
+
+			cout << '\n';
+		}
+
+		cout << endl;
+	}
+}
+
+//	Print the largest displacement component and the largest stress of every element group
+//	of each load case in the file
+void PrintSummary(CResultsFile& Results)
+{
+	cout << setiosflags(ios::scientific) << setprecision(5);
+
+	cout << "  LOAD        MAXIMUM |DISPLACEMENT|    NODE  DOF";
+	for (unsigned int EleGrp = 0; EleGrp < Results.GetNUMEG(); EleGrp++)
+		cout << "   MAXIMUM |STRESS| GROUP" << setw(3) << EleGrp + 1 << "  ELEMENT";
+	cout << endl;
+
+	for (unsigned int lcase = 0; lcase < Results.GetNumberOfLoadCases(); lcase++)
+	{
+		const double* Displacements = Results.GetDisplacements(lcase);
+		size_t NDOF = (size_t)Results.GetNUMNP() * Results.GetNDF();
+
+		size_t Max = 0;
+		for (size_t i = 1; i < NDOF; i++)
+			if (fabs(Displacements[i]) > fabs(Displacements[Max]))
+				Max = i;
+
+		cout << setw(6) << Results.GetLoadCase(lcase) << setw(28) << (NDOF ? Displacements[Max] : 0.0)
+			 << setw(9) << Max / Results.GetNDF() + 1 << setw(5) << Max % Results.GetNDF() + 1;
+
+//		The stress is the last column of the stresses of an element
+		for (unsigned int EleGrp = 0; EleGrp < Results.GetNUMEG(); EleGrp++)
+		{
+			const double* Stresses = Results.GetStresses(lcase, EleGrp);
+			unsigned int NCOL = Results.GetNCOL(EleGrp);
+			unsigned int NUME = Results.GetNUME(EleGrp);
+
+			size_t MaxEle = 0;
+			for (size_t Ele = 1; NCOL && Ele < NUME; Ele++)
+				if (fabs(Stresses[Ele * NCOL + NCOL - 1]) > fabs(Stresses[MaxEle * NCOL + NCOL - 1]))
+					MaxEle = Ele;
+
+			cout << setw(27) << (NCOL && NUME ? Stresses[MaxEle * NCOL + NCOL - 1] : 0.0) << setw(9) << MaxEle + 1;
+		}
+
+		cout << '\n';
+	}
+
+	cout << endl;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		PrintUsage();
+		exit(1);
+	}
+
+	long LoadCase = 0;	// Load case to print (0 : summary of all load cases)
+
+	for (int arg = 1; arg < argc - 1; arg++)
+	{
+		string option(argv[arg]);
+
+		if (option == "-case" && arg + 1 < argc - 1)
+			LoadCase = atol(argv[++arg]);
+		else
+		{
+			cout << "*** Error *** Invalid option: " << option << endl;
+			PrintUsage();
+			exit(1);
+		}
+	}
+
+	string FileName(argv[argc - 1]);
+
+	CResultsFile Results;
+	if (!Results.Open(FileName))
+	{
+		cerr << "*** Error *** File " << FileName << " is not a binary results file of this machine !" << endl;
+		exit(3);
+	}
+
+	cout << "TITLE : " << Results.GetTitle() << endl << endl
+		 << "     NUMBER OF NODAL POINTS . . . . . . . . . . (NUMNP)  = " << setw(10) << Results.GetNUMNP() << endl
+		 << "     NUMBER OF ELEMENT GROUPS . . . . . . . . . (NUMEG)  = " << setw(10) << Results.GetNUMEG() << endl
+		 << "     NUMBER OF LOAD CASES . . . . . . . . . . . (NLCASE) = " << setw(10) << Results.GetNLCASE() << endl
+		 << "     NUMBER OF LOAD CASES IN THE FILE . . . . . . . . .  = " << setw(10) << Results.GetNumberOfLoadCases() << endl << endl;
+
+	if (!LoadCase)
+	{
+		PrintSummary(Results);
+		return 0;
+	}
+
+	for (unsigned int lcase = 0; lcase < Results.GetNumberOfLoadCases(); lcase++)
+		if (Results.GetLoadCase(lcase) == LoadCase)
+		{
+			PrintLoadCase(Results, lcase);
+			return 0;
+		}
+
+	cerr << "*** Error *** Load case " << LoadCase << " is not in file " << FileName << " !" << endl;
+
+	return 1;
+}